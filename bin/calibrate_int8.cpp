@@ -0,0 +1,126 @@
+#include <chrono>
+#include <fstream>
+#include <training/utils.hpp>
+
+/*
+    Calibrates int8 inference of model on dataset (format of
+    DatasetValidator) and reports its accuracy versus fp32. Saved ranges are
+    used by:
+        model.load(weights);
+        model.load_calibration(ranges);
+        model.quantize();
+*/
+int main(int argc, char** argv) {
+    if (argc != 5) {
+        std::cerr << "Invalid number of arguments!\n";
+        std::cerr << "Usage: ./calibrate_int8 config_file model dataset out\n";
+        return 1;
+    }
+
+    YAML::Node config = YAML::LoadFile(argv[1]);
+
+    if (not config["model"]) {
+        std::cerr << "Config require: model\n";
+        return 1;
+    }
+
+    auto model = parse_model(config["model"]);
+
+    std::ifstream model_file(argv[2], std::ios::binary);
+    model->load(model_file);
+    model_file.close();
+
+    std::ifstream data(argv[3], std::ios::binary);
+    if (not data.is_open()) {
+        std::cerr << "Can't open dataset: " << argv[3] << "\n";
+        return 1;
+    }
+
+    int cnt;
+    data.read(reinterpret_cast<char*>(&cnt), sizeof(cnt));
+
+    const size_t policy_size = model->get_output().size - 1;
+    std::vector<float> skipped(policy_size + 1);
+    std::vector<Tensor> inputs(cnt, model->input_layer->get_output());
+
+    for (auto& input : inputs) {
+        input.load(data);
+        //* policy and value targets aren't needed
+        data.read(reinterpret_cast<char*>(skipped.data()),
+                  sizeof(float) * skipped.size());
+    }
+
+    std::cerr << "Samples: " << cnt << "\n";
+
+    std::vector<Tensor> outputs;
+    long long fp32_us = 0;
+
+    for (const auto& input : inputs) {
+        model->set_input(input);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        model->forward();
+        auto end = std::chrono::high_resolution_clock::now();
+        fp32_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                       end - start)
+                       .count();
+
+        model->calibrate();
+        outputs.push_back(model->get_output());
+    }
+
+    if (not model->quantize()) {
+        std::cerr << "No layer can be quantized\n";
+        return 1;
+    }
+
+    float value_diff = 0, value_max_diff = 0;
+    float policy_diff = 0, policy_max_diff = 0;
+    int same_best = 0;
+    long long int8_us = 0;
+
+    for (int i = 0; i < cnt; i++) {
+        model->set_input(inputs[i]);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        model->forward();
+        auto end = std::chrono::high_resolution_clock::now();
+        int8_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                       end - start)
+                       .count();
+
+        const auto& fp32 = outputs[i];
+        const auto& int8 = model->get_output();
+
+        const float diff = std::abs(fp32.get_element(0) - int8.get_element(0));
+        value_diff += diff;
+        value_max_diff = std::max(value_max_diff, diff);
+
+        size_t fp32_best = 0, int8_best = 0;
+        for (size_t move = 0; move < policy_size; move++) {
+            const float a = fp32.get_element(move + 1);
+            const float b = int8.get_element(move + 1);
+
+            policy_diff += std::abs(a - b);
+            policy_max_diff = std::max(policy_max_diff, std::abs(a - b));
+
+            if (a > fp32.get_element(fp32_best + 1)) fp32_best = move;
+            if (b > int8.get_element(int8_best + 1)) int8_best = move;
+        }
+
+        same_best += fp32_best == int8_best;
+    }
+
+    std::cerr << "value mean diff=" << value_diff / cnt
+              << " max diff=" << value_max_diff << "\n";
+    std::cerr << "policy mean diff=" << policy_diff / (cnt * policy_size)
+              << " max diff=" << policy_max_diff << "\n";
+    std::cerr << "same best move=" << (float)same_best / cnt << "\n";
+    std::cerr << "fp32 " << fp32_us << "us int8 " << int8_us << "us\n";
+
+    std::ofstream out(argv[4], std::ios::binary);
+    model->save_calibration(out);
+    out.close();
+
+    return 0;
+}
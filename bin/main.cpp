@@ -43,6 +43,7 @@ int threads;
 int self_play_games;
 int pit_play_games;
 float win_rate_accepted;
+int evaluation_cache_size = 0;
 MCTSConfig self_play_config;
 MCTSConfig validation_config;
 MCTSConfig pit_play_config;
@@ -108,6 +109,39 @@ size_t hash_tensor(const Tensor& tensor) {
     return seed;
 }
 
+//* nullptr if cache is disabled
+std::shared_ptr<EvaluationCache> make_evaluation_cache() {
+    if (evaluation_cache_size <= 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<EvaluationCache>(
+        evaluation_cache_size, game->get_maximum_number_of_moves());
+}
+
+void send_cache_stats(
+    std::string tag, const std::vector<std::shared_ptr<EvaluationCache>>& caches,
+    int step) {
+    uint64_t hits = 0, misses = 0;
+
+    for (const auto& cache : caches) {
+        if (cache) {
+            hits += cache->get_hits();
+            misses += cache->get_misses();
+        }
+    }
+
+    if (hits + misses == 0) {
+        return;
+    }
+
+    const float hit_rate = (float)hits / (float)(hits + misses);
+    std::cerr << "[CPP] evaluation cache hits: " << hits
+              << " misses: " << misses << " hit rate: " << hit_rate << "\n";
+
+    send_scalar(tag + "/Evaluation cache hit rate", hit_rate, step);
+}
+
 void average_samples_scores(
     std::vector<std::unique_ptr<SelfPlayWorker>>& self_play_workers,
     int generation) {
@@ -259,6 +293,12 @@ void self_play(int generation) {
 
     std::vector<std::unique_ptr<SelfPlayWorker>> self_play_workers;
 
+    //* one cache per model, shared by all threads
+    std::vector<std::shared_ptr<EvaluationCache>> caches;
+    for (int i = 0; i < models_paths.size(); i++) {
+        caches.push_back(make_evaluation_cache());
+    }
+
     auto best_model_factory = [=]() {
         Model model = *parse_model(config["model"]);
 
@@ -266,6 +306,8 @@ void self_play(int generation) {
         model.load(file);
         file.close();
 
+        model.set_cache(caches[0]);
+
         return model;
     };
 
@@ -277,6 +319,8 @@ void self_play(int generation) {
             model.load(file);
             file.close();
 
+            model.set_cache(caches[i]);
+
             return model;
         };
 
@@ -320,6 +364,8 @@ void self_play(int generation) {
 
     std::cerr << "[CPP] Samples count: " << samples_cnt << "\n";
 
+    send_cache_stats("Self Play", caches, generation);
+
     average_samples_scores(self_play_workers, generation);
 
     int type = 4;
@@ -486,6 +532,9 @@ void comparision(int generation) {
     std::cin.read(reinterpret_cast<char*>(candidate_model_bytes.data()),
                   model_bytes);
 
+    std::vector<std::shared_ptr<EvaluationCache>> caches{
+        make_evaluation_cache()};
+
     auto candidate_model_factory = [=]() {
         std::stringstream ss;
 
@@ -497,6 +546,8 @@ void comparision(int generation) {
 
         model.load(stream);
 
+        model.set_cache(caches[0]);
+
         return model;
     };
 
@@ -517,6 +568,9 @@ void comparision(int generation) {
         std::string best_model_path = config["data_path"].as<std::string>() +
                                       "/models/model_" + best_model_generation;
 
+        auto best_cache = make_evaluation_cache();
+        caches.push_back(best_cache);
+
         auto best_model_factory = [=]() {
             Model model = *parse_model(config["model"]);
 
@@ -524,6 +578,8 @@ void comparision(int generation) {
             model.load(file);
             file.close();
 
+            model.set_cache(best_cache);
+
             return model;
         };
 
@@ -540,6 +596,7 @@ void comparision(int generation) {
     }
 
     send_scalar("Comparision/win rate", candidate_win_ratio, generation);
+    send_cache_stats("Comparision", caches, generation);
 
     if (candidate_win_ratio >= win_rate_accepted) {
         models_stats["best2"] = models_stats["best1"].as<std::string>();
@@ -664,6 +721,12 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if (config["evaluation_cache_size"]) {
+        evaluation_cache_size = config["evaluation_cache_size"].as<int>();
+        std::cerr << "Loading evaluation_cache_size: " << evaluation_cache_size
+                  << "\n";
+    }
+
     if (config["self_play_config"]) {
         std::cerr << "Loading self_play_config\n";
         self_play_config = parse_mcts_config(config["self_play_config"]);
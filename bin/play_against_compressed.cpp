@@ -8,6 +8,7 @@ YAML::Node config;
 Game game;
 std::string data_path;
 int threads;
+int game_time_ms = -1;
 MCTSConfig self_play_config;
 
 std::string read_file(std::string filename) {
@@ -76,6 +77,11 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if (config["game_time_ms"]) {
+        game_time_ms = config["game_time_ms"].as<int>();
+        std::cerr << "Loading game_time_ms: " << game_time_ms << "\n";
+    }
+
     if (config["self_play_config"]) {
         std::cerr << "Loading self_play_config\n";
         self_play_config = parse_mcts_config(config["self_play_config"]);
@@ -140,9 +146,9 @@ int main(int argc, char** argv) {
 
     auto temp = self_play_config;
 
-    auto pit_play_worker =
-        PitPlayWorker(game, compressed_model_factory, temp,
-                      model_factory, self_play_config, 500, threads, true, 30);
+    auto pit_play_worker = PitPlayWorker(
+        game, compressed_model_factory, temp, model_factory, self_play_config,
+        500, threads, true, 30, game_time_ms);
 
     auto wr = pit_play_worker.get_first_player_winrate();
 
@@ -0,0 +1,45 @@
+#include <games/connect4.hpp>
+#include <games/oware.hpp>
+#include <games/tictactoe.hpp>
+#include <model/model.hpp>
+
+//* random playout with push_state, then unmake every move and compare
+template <class GameT>
+void check_unmake(int playouts) {
+    for (int playout = 0; playout < playouts; playout++) {
+        std::shared_ptr<AbstractGame<Tensor>> game = std::make_shared<GameT>();
+        std::vector<std::shared_ptr<AbstractGame<Tensor>>> states;
+
+        while (not game->is_terminal()) {
+            states.push_back(game->clone());
+
+            game->calc_legal_moves();
+            auto move = game->legal_moves[rand() % game->legal_moves_cnt];
+            game->push_state();
+            game->make_move(move);
+        }
+
+        while (not states.empty()) {
+            game->unmake_move();
+
+            if (not game->equal(states.back()) or
+                game->calc_hash() != states.back()->calc_hash()) {
+                std::cerr << "unmake_move doesn't restore state!\n";
+                game->debug();
+                exit(1);
+            }
+
+            states.pop_back();
+        }
+    }
+}
+
+int main() {
+    srand(time(0));
+
+    check_unmake<TicTacToeGame<Tensor>>(1000);
+    check_unmake<Connect4Game<Tensor>>(1000);
+    check_unmake<OwareGame<Tensor>>(1000);
+
+    std::cerr << "OK\n";
+}
@@ -0,0 +1,71 @@
+#include <games/oware.hpp>
+#include <games/tictactoe.hpp>
+#include <mcts/MCTS.hpp>
+
+#include "../test_utils.hpp"
+
+//* Gumbel root search plays legal moves and its improved policy is proper
+
+template <class GameT>
+void check_gumbel(int inputs, int outputs) {
+    Model model = make_model(inputs, outputs);
+
+    auto game = std::make_shared<GameT>();
+    Sample sample(game->get_input_shape(),
+                  game->get_maximum_number_of_moves());
+
+    //* budgets below, equal to and above number of actions
+    for (int iterations : {1, 4, 16, 100}) {
+        for (int actions : {1, 2, 4, 16}) {
+            MCTSConfig config;
+            config.number_of_iterations_per_turn = iterations;
+            config.gumbel = true;
+            config.gumbel_actions = actions;
+
+            game = std::make_shared<GameT>();
+            MCTS mcts(game, config);
+
+            //* few moves of game, tree is kept between them as in self play
+            for (int turn = 0; turn < 6 and not game->is_terminal(); turn++) {
+                mcts.search(model);
+
+                game->calc_legal_moves();
+                const auto legal = std::vector<int>(
+                    game->legal_moves.begin(),
+                    game->legal_moves.begin() + game->legal_moves_cnt);
+
+                mcts.get_sample(sample);
+
+                float sum = 0;
+                for (int move = 0; move < (int)sample.policy.size(); move++) {
+                    const bool is_legal =
+                        std::find(legal.begin(), legal.end(), move) !=
+                        legal.end();
+
+                    check(sample.policy[move] >= 0, "negative policy");
+                    check(is_legal or sample.policy[move] == 0,
+                          "policy of illegal move " + std::to_string(move));
+                    sum += sample.policy[move];
+                }
+
+                check(std::abs(sum - 1) < 1e-5,
+                      "improved policy sums to " + std::to_string(sum));
+
+                const int best = mcts.get_best();
+                check(std::find(legal.begin(), legal.end(), best) !=
+                          legal.end(),
+                      "best move " + std::to_string(best) + " isn't legal");
+
+                game->make_move(best);
+                mcts.restore_root(best, model);
+            }
+        }
+    }
+}
+
+int main() {
+    check_gumbel<TicTacToeGame<Tensor>>(18, 10);
+    check_gumbel<OwareGame<Tensor>>(342, 7);
+
+    std::cerr << "OK\n";
+}
@@ -0,0 +1,75 @@
+#include <games/oware.hpp>
+#include <games/tictactoe.hpp>
+#include <mcts/MCTS.hpp>
+
+#include "../test_utils.hpp"
+
+/*
+    Lazy children keep unvisited children as edges: search allocates
+    fewer nodes, and game played with restore_root (materialized root
+    children) keeps proper visits and sample policy.
+*/
+
+template <class GameT>
+void check_lazy(int inputs, int outputs) {
+    Model model = make_model(inputs, outputs);
+
+    const int iterations = 2000;
+
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = iterations;
+    config.dirichlet_noise_epsilon = 0;
+
+    MCTS eager(std::make_shared<GameT>(), config);
+    eager.search(model);
+
+    config.lazy_children = true;
+    auto game = std::make_shared<GameT>();
+    MCTS lazy(game, config);
+    lazy.search(model);
+
+    check(lazy.get_edges_count() > 0, "lazy search has no edges");
+    check(lazy.get_nodes_count() < eager.get_nodes_count(),
+          "lazy search allocated " + std::to_string(lazy.get_nodes_count()) +
+              " nodes, eager " + std::to_string(eager.get_nodes_count()));
+
+    Sample sample(game->get_input_shape(),
+                  game->get_maximum_number_of_moves());
+
+    for (int turn = 0; turn < 6 and not game->is_terminal(); turn++) {
+        if (turn > 0) {
+            lazy.search(model);
+        }
+
+        const auto analysis = lazy.analyze();
+        check(analysis.root_visits > 0 and analysis.pending_leaves == 0,
+              "lazy search left pending leaves");
+
+        lazy.get_sample(sample);
+
+        float sum = 0;
+        for (const float p : sample.policy) {
+            sum += p;
+        }
+        check(std::abs(sum - 1) < 1e-5,
+              "sample policy sums to " + std::to_string(sum));
+
+        game->calc_legal_moves();
+        const int best = lazy.get_best();
+        check(std::find(game->legal_moves.begin(),
+                        game->legal_moves.begin() + game->legal_moves_cnt,
+                        best) != game->legal_moves.begin() +
+                                     game->legal_moves_cnt,
+              "best move isn't legal");
+
+        game->make_move(best);
+        lazy.restore_root(best, model);
+    }
+}
+
+int main() {
+    check_lazy<TicTacToeGame<Tensor>>(18, 10);
+    check_lazy<OwareGame<Tensor>>(342, 7);
+
+    std::cerr << "OK\n";
+}
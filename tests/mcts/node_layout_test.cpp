@@ -0,0 +1,104 @@
+#include <games/oware.hpp>
+#include <mcts/MCTS.hpp>
+
+#include "../test_utils.hpp"
+
+//* sizes and field encoding of node layouts, search with layout of macros
+
+static_assert(sizeof(MCTSNode) == 36);
+static_assert(sizeof(Relaxed<int>) == sizeof(int));
+static_assert(sizeof(Relaxed<float>) == sizeof(float));
+//* arrays of SoA hold the same fields as MCTSNode
+static_assert(MCTSSoANodes::node_bytes() == sizeof(MCTSNode));
+static_assert(sizeof(MCTSCompactNode) == 20);
+
+//* node written through reference of Nodes and read back as MCTSNode
+template <class Nodes>
+MCTSNode round_trip(const MCTSNode &node) {
+    Nodes nodes;
+    nodes.resize(1);
+    nodes[0] = node;
+    return nodes[0];
+}
+
+template <class Nodes>
+void check_round_trip(bool exact) {
+    //* fp16 keeps 11 significant bits
+    const float eps = exact ? 0.0f : 1.0f / 1024;
+
+    for (float value : {0.0f, 1.0f, -1.0f, 0.5f, -0.75f, 0.1f, -0.3337f}) {
+        MCTSNode node(7, std::abs(value));
+        node.nn_value = value;
+        node.score_sum = value * 3;
+
+        const MCTSNode read = round_trip<Nodes>(node);
+
+        check(std::abs(read.nn_value - value) <= eps * std::abs(value) and
+                  std::abs(read.policy - std::abs(value)) <=
+                      eps * std::abs(value),
+              "fp16 round trip of " + std::to_string(value));
+        check(read.score_sum == value * 3, "score_sum isn't exact");
+    }
+
+    //* 13 bit signed child_count, -1 is pending leaf
+    for (int child_count : {-1, 0, 1, 9, 4095}) {
+        MCTSNode node(3);
+        node.child_count = child_count;
+        node.child_index = 123456;
+        node.visits = 1 << 30;
+
+        const MCTSNode read = round_trip<Nodes>(node);
+
+        check(read.child_count == child_count,
+              "child_count " + std::to_string(child_count));
+        check(read.child_index == 123456 and read.visits == 1 << 30,
+              "child_index or visits changed");
+    }
+
+    //* status -1..2 is stored with bias 1 next to children_draw
+    for (int status : {-1, 0, 1, 2}) {
+        for (int draw : {0, 1}) {
+            MCTSNode node(65535);
+            node.status = status;
+            node.children_draw = draw;
+            node.child_count = -1;
+
+            const MCTSNode read = round_trip<Nodes>(node);
+
+            check(read.status == status and read.children_draw == draw,
+                  "status " + std::to_string(status) + " draw " +
+                      std::to_string(draw));
+            check(read.child_count == -1 and read.move == 65535,
+                  "status changed other fields");
+        }
+    }
+}
+
+int main() {
+    check_round_trip<MCTSSoANodes>(true);
+    check_round_trip<MCTSCompactNodes>(false);
+
+    auto game = std::make_shared<OwareGame<Tensor>>();
+
+    Model model = make_model(342, 7);
+
+    const int iterations = 2000;
+
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = iterations;
+    config.init_reserved_nodes = iterations * 7;
+
+    MCTS mcts(game, config);
+    mcts.search(model);
+
+    check(mcts.analyze().root_visits == iterations, "root visits of layout");
+
+    game->calc_legal_moves();
+    const int best = mcts.get_best();
+    check(std::find(game->legal_moves.begin(),
+                    game->legal_moves.begin() + game->legal_moves_cnt,
+                    best) != game->legal_moves.begin() + game->legal_moves_cnt,
+          "best move isn't legal");
+
+    std::cerr << "OK\n";
+}
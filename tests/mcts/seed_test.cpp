@@ -0,0 +1,83 @@
+#include <games/oware.hpp>
+#include <mcts/MCTS.hpp>
+
+#include "../test_utils.hpp"
+
+//* seeded search is reproducible: same seed, same noise, moves and visits
+
+//* visits of every root child after every move, then moves themselves
+std::vector<int> play(Model &model, MCTSConfig config, bool gumbel) {
+    config.number_of_iterations_per_turn = 200;
+    config.gumbel = gumbel;
+
+    //* the same way as self play seeds game of thread
+    Random::instance().seed(Random::stream_seed(config.seed, 0));
+
+    auto game = std::make_shared<OwareGame<Tensor>>();
+    MCTS mcts(game, config);
+
+    std::vector<int> visits;
+    std::vector<int> moves;
+
+    for (int turn = 0; turn < 20 and not game->is_terminal(); turn++) {
+        mcts.search(model);
+
+        for (const auto &line : mcts.analyze(6, 1).lines) {
+            visits.push_back(line[0].move);
+            visits.push_back(line[0].visits);
+        }
+
+        const int best = mcts.get_best();
+        moves.push_back(best);
+
+        game->make_move(best);
+        mcts.restore_root(best, model);
+    }
+
+    visits.insert(visits.end(), moves.begin(), moves.end());
+    return visits;
+}
+
+//* reseeding mid stream drops normal cached by polar method
+void check_reseed() {
+    auto gammas = [](Random &random) {
+        std::vector<float> out(16);
+        random.seed(7);
+        random.fill_gamma(0.3f, out.data(), out.size());
+        return out;
+    };
+
+    Random fresh;
+    const auto expected = gammas(fresh);
+
+    Random used;
+    used.seed(8);
+    used.next_normal();
+    check(gammas(used) == expected,
+          "gammas after reseed differ from fresh stream");
+}
+
+int main() {
+    check_reseed();
+
+    Model model = make_model(342, 7);
+
+    //* dirichlet noise and temperature are on by default
+    MCTSConfig config;
+    MCTSConfig other = config;
+    config.seed = 7;
+    other.seed = 8;
+
+    for (bool gumbel : {false, true}) {
+        const auto name = std::string(gumbel ? "gumbel" : "puct");
+        const auto first = play(model, config, gumbel);
+
+        check(play(model, config, gumbel) == first,
+              name + " runs with the same seed differ");
+        //* otherwise test would pass without any randomness
+        check(play(model, other, gumbel) != first,
+              name + " runs with different seeds are the same");
+    }
+
+    std::cerr << "OK\n";
+}
@@ -0,0 +1,109 @@
+#include <games/oware.hpp>
+#include <games/tictactoe.hpp>
+#include <mcts/MCTS.hpp>
+
+#include "../test_utils.hpp"
+
+/*
+    Every simulation goes to root child with the best PUCT computed here
+    the way scalar select_child() does it (first best on ties), also with
+    SIMD selection of MCTS_SOA_NODES. TicTacToe has 9 root children (two
+    blocks of 8), Oware 6 (masked lanes).
+*/
+
+template <class GameT>
+void check_select(int inputs, int outputs, int simulations) {
+    Model model = make_model(inputs, outputs);
+
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = 1;
+    config.dirichlet_noise_epsilon = 0;
+    config.cpuct_init = 2;
+
+    auto game = std::make_shared<GameT>();
+    MCTS mcts(game, config);
+
+    //* children are in order of legal moves, priors as stored in them
+    game->calc_legal_moves();
+    const std::vector<int> moves(
+        game->legal_moves.begin(),
+        game->legal_moves.begin() + game->legal_moves_cnt);
+
+    model.set_input(*game);
+    model.forward(*game);
+
+    std::vector<float> priors;
+    for (const int move : moves) {
+        priors.push_back(model.get_policy(move));
+    }
+
+    //* root expansion
+    mcts.search(model);
+
+    for (int i = 0; i < simulations; i++) {
+        const auto before = mcts.analyze(moves.size(), 1);
+
+        const float cpuct = config.cpuct_init;
+        const float parent =
+            before.root_visits <= 1 ? cpuct
+                                    : cpuct * fastsqrtf(before.root_visits);
+
+        float best_U = -1e9f;
+        int expected = -1;
+
+        for (size_t c = 0; c < moves.size(); c++) {
+            int visits = 0;
+            float q = -1;
+            int status = 2;
+
+            for (const auto &line : before.lines) {
+                if (line[0].move == moves[c]) {
+                    visits = line[0].visits;
+                    q = line[0].q;
+                    status = line[0].status;
+                }
+            }
+
+            if (status == 1) {
+                continue;
+            }
+
+            const float U = q + parent * priors[c] * fastinv(1 + visits);
+
+            if (U > best_U) {
+                best_U = U;
+                expected = moves[c];
+            }
+        }
+
+        mcts.search(model);
+        const auto after = mcts.analyze(moves.size(), 1);
+
+        int selected = -1;
+        for (const auto &line : after.lines) {
+            int visits = 0;
+
+            for (const auto &old : before.lines) {
+                if (old[0].move == line[0].move) {
+                    visits = old[0].visits;
+                }
+            }
+
+            if (line[0].visits > visits) {
+                selected = line[0].move;
+            }
+        }
+
+        check(selected == expected,
+              "simulation " + std::to_string(i) + " selected " +
+                  std::to_string(selected) + " instead of " +
+                  std::to_string(expected));
+    }
+}
+
+int main() {
+    check_select<TicTacToeGame<Tensor>>(18, 10, 300);
+    check_select<OwareGame<Tensor>>(342, 7, 300);
+
+    std::cerr << "OK\n";
+}
@@ -0,0 +1,93 @@
+#include <games/tictactoe.hpp>
+#include <mcts/MCTS.hpp>
+
+#include "../test_utils.hpp"
+
+//* solver proves TicTacToe positions and stops search on proven root
+
+/*
+    Searches position after moves, best move has to be one of best_moves
+    and solved with expected status for player making it (-1 win, 0 draw,
+    1 lose, as status of node after move).
+*/
+void check_proof(Model &model, const std::vector<int> &moves, int expected,
+                 const std::vector<int> &best_moves) {
+    const int iterations = 100'000;
+
+    auto game = std::make_shared<TicTacToeGame<Tensor>>();
+    for (const int move : moves) {
+        game->make_move(move);
+    }
+
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = iterations;
+    config.dirichlet_noise_epsilon = 0;
+    config.temperature_turns = 0;
+
+    MCTS mcts(game, config);
+    mcts.search(model);
+
+    const int best = mcts.get_best();
+    const auto analysis = mcts.analyze(9, 1);
+
+    int status = 2;
+    for (const auto &line : analysis.lines) {
+        if (line[0].move == best) {
+            status = line[0].status;
+        }
+    }
+
+    check(status == expected, "status " + std::to_string(status) +
+                                  " instead of " + std::to_string(expected));
+    check(std::find(best_moves.begin(), best_moves.end(), best) !=
+              best_moves.end(),
+          "best move " + std::to_string(best) + " isn't proven one");
+    check(analysis.simulations < iterations,
+          "search didn't stop on proven root");
+}
+
+//* counters of partial proofs move with their nodes in compact()
+void check_compacted_proof(Model &model) {
+    auto game = std::make_shared<TicTacToeGame<Tensor>>();
+    for (const int move : {4, 0}) {
+        game->make_move(move);
+    }
+
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = 3000;
+    config.dirichlet_noise_epsilon = 0;
+
+    MCTS mcts(game, config);
+    mcts.search(model);
+    mcts.compact();
+
+    config.number_of_iterations_per_turn = 100'000;
+    mcts.set_iterations_per_turn(config.number_of_iterations_per_turn);
+    mcts.search(model);
+
+    const auto analysis = mcts.analyze(9, 1);
+    for (const auto &line : analysis.lines) {
+        check(line[0].status == 0, "move " + std::to_string(line[0].move) +
+                                       " isn't proven draw after compact");
+    }
+    check(analysis.simulations < config.number_of_iterations_per_turn,
+          "search didn't stop on proven root after compact");
+}
+
+int main() {
+    Model model = make_model(18, 10);
+
+    //* X wins in one move
+    check_proof(model, {0, 3, 1, 4}, -1, {2});
+    //* X wins with fork on 3 or 6, other moves only draw
+    check_proof(model, {0, 1, 4, 8}, -1, {3, 6});
+    //* O blocks 2, X forks with 4
+    check_proof(model, {0, 3, 1}, 1, {2, 4, 5, 6, 7, 8});
+    //* X has to block 1, then nobody wins
+    check_proof(model, {4, 0, 8, 2}, 0, {1});
+    //* every move draws
+    check_proof(model, {4, 0}, 0, {1, 2, 3, 5, 6, 7, 8});
+    check_compacted_proof(model);
+
+    std::cerr << "OK\n";
+}
@@ -0,0 +1,66 @@
+#include <games/tictactoe.hpp>
+#include <mcts/MCTS.hpp>
+
+#include "../test_utils.hpp"
+
+/*
+    Equal positions reached by other move orders share children: search
+    allocates fewer nodes, and solver proves position whose children are
+    solved through other parents.
+*/
+
+MCTSConfig make_config(int iterations, int transposition_table_size) {
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = iterations;
+    config.dirichlet_noise_epsilon = 0;
+    config.temperature_turns = 0;
+    config.transposition_table_size = transposition_table_size;
+    return config;
+}
+
+void check_sharing(Model &model) {
+    MCTS plain(std::make_shared<TicTacToeGame<Tensor>>(),
+               make_config(2000, 0));
+    plain.search(model);
+
+    MCTS shared(std::make_shared<TicTacToeGame<Tensor>>(),
+                make_config(2000, 1 << 16));
+    shared.search(model);
+
+    check(shared.get_nodes_count() < plain.get_nodes_count(),
+          "table doesn't share nodes, " +
+              std::to_string(shared.get_nodes_count()) + " nodes instead of " +
+              std::to_string(plain.get_nodes_count()));
+}
+
+//* every move after 4, 0 draws, most children are reached many ways
+void check_proof(Model &model) {
+    const int iterations = 100'000;
+
+    auto game = std::make_shared<TicTacToeGame<Tensor>>();
+    for (const int move : {4, 0}) {
+        game->make_move(move);
+    }
+
+    MCTS mcts(game, make_config(iterations, 1 << 16));
+    mcts.search(model);
+
+    const auto analysis = mcts.analyze(9, 1);
+
+    check(analysis.simulations < iterations, "root isn't proven");
+
+    for (const auto &line : analysis.lines) {
+        check(line[0].status == 0,
+              "move " + std::to_string(line[0].move) + " has status " +
+                  std::to_string(line[0].status) + " instead of draw");
+    }
+}
+
+int main() {
+    Model model = make_model(18, 10);
+
+    check_sharing(model);
+    check_proof(model);
+
+    std::cerr << "OK\n";
+}
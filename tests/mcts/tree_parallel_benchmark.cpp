@@ -0,0 +1,46 @@
+#include <chrono>
+#include <games/oware.hpp>
+#include <mcts/MCTS.hpp>
+#include <thread>
+
+//* simulations per second of tree-parallel search for 1..N threads
+int main() {
+    auto game = std::make_shared<OwareGame<Tensor>>();
+
+    ModelFactory factory = []() {
+        Model model(std::make_shared<InputLayer>(std::vector<size_t>{342}),
+                    std::make_shared<LinearLayer>(64, activationRELU),
+                    std::make_shared<LinearLayer>(64, activationRELU),
+                    std::make_shared<LinearLayer>(7));
+        model.fill_random(-0.1, 0.1);
+        return model;
+    };
+
+    const int iterations = 20'000;
+    const int max_threads =
+        std::max(1u, std::thread::hardware_concurrency());
+
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = iterations;
+    config.init_reserved_nodes = iterations * 7;
+
+    for (int threads = 1; threads <= max_threads; threads++) {
+        std::vector<Model> models;
+        for (int i = 0; i < threads; i++) {
+            models.push_back(factory());
+        }
+
+        MCTS mcts(game, config);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        mcts.search(models);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        const float seconds =
+            std::chrono::duration<float>(end - start).count();
+
+        std::cerr << "threads: " << threads
+                  << " simulations/s: " << iterations / seconds
+                  << " best: " << mcts.get_best() << "\n";
+    }
+}
@@ -0,0 +1,138 @@
+#include <games/oware.hpp>
+#include <games/tictactoe.hpp>
+#include <mcts/MCTS.hpp>
+#include <sstream>
+
+#include "../test_utils.hpp"
+
+//* tree-parallel search keeps statistics of single threaded one
+const int threads = 4;
+
+//* models with own layers and the same random weights
+std::vector<Model> make_models(int count, int inputs, int outputs) {
+    std::vector<Model> models;
+    std::stringstream weights;
+
+    for (int i = 0; i < count; i++) {
+        Model model = make_model(inputs, outputs);
+
+        if (i == 0) {
+            model.save(weights);
+        } else {
+            weights.seekg(0);
+            model.load(weights);
+        }
+
+        models.push_back(model);
+    }
+
+    return models;
+}
+
+//* every simulation is one root visit, virtual losses are removed
+template <class GameT>
+void check_statistics(int iterations, int inputs, int outputs) {
+    auto models = make_models(threads, inputs, outputs);
+
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = iterations;
+    config.init_reserved_nodes = iterations * 10;
+    config.dirichlet_noise_epsilon = 0;
+    config.search_threads = threads;
+
+    MCTS mcts(std::make_shared<GameT>(), config);
+    mcts.search(models);
+    const auto analysis = mcts.analyze();
+
+    check(analysis.root_visits == iterations,
+          "root visits " + std::to_string(analysis.root_visits) +
+              " instead of " + std::to_string(iterations));
+    check(analysis.pending_leaves == 0,
+          std::to_string(analysis.pending_leaves) +
+              " leaves with virtual loss left");
+}
+
+//* default config has no reserved nodes, timed threads reserve their own
+void check_timed() {
+    auto models = make_models(threads, 342, 7);
+
+    MCTSConfig config;
+    config.search_threads = threads;
+
+    MCTS mcts(std::make_shared<OwareGame<Tensor>>(), config);
+    mcts.search(models, 100);
+    const auto analysis = mcts.analyze();
+
+    check(analysis.root_visits > 1000,
+          "timed search made only " + std::to_string(analysis.root_visits) +
+              " root visits");
+    check(analysis.pending_leaves == 0,
+          std::to_string(analysis.pending_leaves) +
+              " leaves with virtual loss left after timed search");
+}
+
+//* threads search with budget of time manager and keep to its limit
+void check_time_manager() {
+    auto models = make_models(threads, 342, 7);
+
+    MCTSConfig config;
+    config.search_threads = threads;
+
+    MCTS mcts(std::make_shared<OwareGame<Tensor>>(), config);
+    TimeManager time(-1, 100);
+    const int maximum = time.maximum_time();
+
+    Stopwatch watch(0);
+    mcts.search(models, time);
+    const long long elapsed = watch.elapsed_milliseconds();
+    const auto analysis = mcts.analyze();
+
+    check(analysis.root_visits > 1000,
+          "time managed search made only " +
+              std::to_string(analysis.root_visits) + " root visits");
+    check(elapsed <= maximum + 10,
+          "time managed search took " + std::to_string(elapsed) + " ms");
+    check(analysis.pending_leaves == 0,
+          std::to_string(analysis.pending_leaves) +
+              " leaves with virtual loss left after time managed search");
+}
+
+//* X to move wins by completing top row, O threatens middle row
+void check_forced_win() {
+    TicTacToeGame<Tensor> game;
+    for (int move : {0, 3, 1, 4}) {
+        game.make_move(move);
+    }
+
+    auto models = make_models(threads, 18, 10);
+    std::vector<Model> single(models.begin(), models.begin() + 1);
+
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = 2000;
+    config.init_reserved_nodes = 20'000;
+    config.dirichlet_noise_epsilon = 0;
+
+    MCTS reference(std::make_shared<TicTacToeGame<Tensor>>(game), config);
+    reference.search(single);
+
+    config.search_threads = threads;
+    MCTS mcts(std::make_shared<TicTacToeGame<Tensor>>(game), config);
+    mcts.search(models);
+
+    check(reference.get_best() == 2, "single thread misses win");
+    check(mcts.get_best() == reference.get_best(),
+          "threads choose other move than single thread");
+    check(mcts.analyze().pending_leaves == 0,
+          "leaves with virtual loss left after solved search");
+}
+
+int main() {
+    //* tictactoe tree is small, most simulations end in solved nodes
+    check_statistics<TicTacToeGame<Tensor>>(2000, 18, 10);
+    check_statistics<OwareGame<Tensor>>(20'000, 342, 7);
+    check_timed();
+    check_time_manager();
+    check_forced_win();
+
+    std::cerr << "OK\n";
+}
@@ -0,0 +1,121 @@
+#include <games/tictactoe.hpp>
+#include <mcts/pit_play_worker.hpp>
+#include <mcts/self_play_worker.hpp>
+#include <sstream>
+
+#include "../test_utils.hpp"
+
+/*
+    Seeded workers play the same games: self play gives the same samples
+    and results, pit play the same results, also with other number of
+    threads.
+*/
+const int games = 12;
+
+//* every model made by factory has the same random weights
+ModelFactory make_factory() {
+    std::stringstream weights;
+    make_model(18, 10).save(weights);
+
+    return [data = weights.str()]() {
+        Model model = make_model(18, 10);
+        std::stringstream in(data);
+        model.load(in);
+        return model;
+    };
+}
+
+MCTSConfig make_config(int seed) {
+    MCTSConfig config;
+    config.number_of_iterations_per_turn = 100;
+    //* playout cap randomization uses random stream of worker too
+    config.full_search_probability = 0.5f;
+    config.fast_iterations_per_turn = 20;
+    config.seed = seed;
+
+    return config;
+}
+
+bool same_samples(const SelfPlayWorker &a, const SelfPlayWorker &b) {
+    if (a.game_samples_count != b.game_samples_count) {
+        return false;
+    }
+
+    for (int i = 0; i < a.game_samples_count; i++) {
+        const Sample &x = a.game_samples[i];
+        const Sample &y = b.game_samples[i];
+
+        if (x.policy != y.policy or x.legal_moves != y.legal_moves or
+            x.score != y.score) {
+            return false;
+        }
+
+        for (size_t j = 0; j < x.input.size; j++) {
+            if (x.input.get_element(j) != y.input.get_element(j)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool same_results(const SelfPlayWorker &a, const SelfPlayWorker &b) {
+    return a.games_won_ == b.games_won_ and a.games_lost_ == b.games_lost_ and
+           a.draws_ == b.draws_ and a.games_length == b.games_length and
+           a.first_moves_vis == b.first_moves_vis;
+}
+
+void check_self_play(const ModelFactory &factory) {
+    auto game = std::make_shared<TicTacToeGame<Tensor>>();
+    const auto config = make_config(7);
+
+    SelfPlayWorker first(game, factory, config, factory, config, games, 1);
+
+    for (int threads : {1, 3}) {
+        SelfPlayWorker other(game, factory, config, factory, config, games,
+                             threads);
+        const auto name = std::to_string(threads) + " threads";
+
+        check(same_samples(first, other),
+              "self play samples differ with " + name);
+        check(same_results(first, other),
+              "self play results differ with " + name);
+    }
+
+    //* otherwise test would pass without any randomness
+    const auto other_config = make_config(8);
+    SelfPlayWorker other(game, factory, other_config, factory, other_config,
+                         games, 1);
+    check(not same_samples(first, other),
+          "self play with different seeds gives the same samples");
+}
+
+void check_pit_play(const ModelFactory &factory) {
+    auto game = std::make_shared<TicTacToeGame<Tensor>>();
+    const auto config = make_config(7);
+
+    PitPlayWorker first(game, factory, config, factory, config, games, 1);
+
+    for (int threads : {1, 3}) {
+        PitPlayWorker other(game, factory, config, factory, config, games,
+                            threads);
+        const auto name = std::to_string(threads) + " threads";
+
+        check(other.get_first_player_winrate() ==
+                  first.get_first_player_winrate(),
+              "pit play winrate differs with " + name);
+        check(other.get_average_game_length() ==
+                  first.get_average_game_length(),
+              "pit play game length differs with " + name);
+    }
+}
+
+int main() {
+    const ModelFactory factory = make_factory();
+
+    check_self_play(factory);
+    check_pit_play(factory);
+
+    std::cerr << "OK\n";
+}
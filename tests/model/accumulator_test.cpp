@@ -0,0 +1,136 @@
+#include <games/oware.hpp>
+#include <games/tictactoe.hpp>
+#include <model/model.hpp>
+
+/*
+    Accumulator updated move by move along random games (and back with
+    unmake_move) against refresh of every position and dense forward of
+    model. Sums differ by rounding of added and subtracted rows only.
+*/
+const float tolerance = 1e-4f;
+
+//* first size elements, Accumulator::values has only xmm allocated
+float max_diff(const Tensor &a, const Tensor &b, size_t size) {
+    float diff = 0;
+    for (size_t i = 0; i < size; i++) {
+        diff = std::max(diff, std::abs(a.xmm[0].f[i] - b.xmm[0].f[i]));
+    }
+    return diff;
+}
+
+void check(float diff, const std::string &msg) {
+    if (not(diff <= tolerance)) {
+        std::cerr << msg << " differs by " << diff << "\n";
+        exit(1);
+    }
+}
+
+//* accumulators of both players of one position
+struct Ply {
+    std::vector<int> features[2];
+    int count[2];
+    Accumulator accumulators[2];
+};
+
+template <class GameT>
+void check_game(int inputs, int outputs, int games) {
+    Model model(std::make_shared<InputLayer>(std::vector<size_t>{
+                    (size_t)inputs}),
+                std::make_shared<LinearLayer>(64, activationRELU),
+                std::make_shared<LinearLayer>(outputs));
+    model.fill_random(-0.5, 0.5);
+
+    const LinearLayer &layer = *model.get_feature_layer();
+
+    auto compute = [&](const GameT &game, Ply &ply, const Ply *parent) {
+        for (int player : {0, 1}) {
+            ply.features[player].resize(inputs);
+            ply.count[player] =
+                game.get_active_features(player, ply.features[player].data());
+
+            if (parent == nullptr) {
+                ply.accumulators[player].refresh(
+                    layer, ply.features[player].data(), ply.count[player]);
+            } else {
+                ply.accumulators[player].update(
+                    parent->accumulators[player], layer,
+                    parent->features[player].data(), parent->count[player],
+                    ply.features[player].data(), ply.count[player]);
+            }
+        }
+    };
+
+    //* accumulators of ply against refresh and model against dense forward
+    auto verify = [&](GameT &game, const Ply &ply) {
+        for (int player : {0, 1}) {
+            Accumulator refreshed;
+            refreshed.refresh(layer, ply.features[player].data(),
+                              ply.count[player]);
+            check(max_diff(ply.accumulators[player].values, refreshed.values,
+                           layer.out_features),
+                  "accumulator");
+        }
+
+        if (game.is_terminal()) {
+            return;
+        }
+
+        game.calc_legal_moves();
+        game.get_input_for_network(model.input_layer->get_output());
+        model.forward(game);
+        const Tensor dense = model.get_output();
+
+        model.forward(ply.accumulators[game.get_player_to_move()], game);
+        check(max_diff(model.get_output(), dense, dense.size),
+              "model output");
+    };
+
+    for (int g = 0; g < games; g++) {
+        GameT game;
+        std::vector<Ply> plies(1);
+        compute(game, plies[0], nullptr);
+
+        while (not game.is_terminal()) {
+            game.calc_legal_moves();
+            const int move = game.legal_moves[rand() % game.legal_moves_cnt];
+
+            game.push_state();
+            game.make_move(move);
+
+            plies.emplace_back();
+            compute(game, plies.back(), &plies[plies.size() - 2]);
+            verify(game, plies.back());
+        }
+
+        //* features of restored positions are the ones accumulated
+        while (plies.size() > 1) {
+            game.unmake_move();
+            plies.pop_back();
+
+            Ply restored;
+            compute(game, restored, nullptr);
+            for (int player : {0, 1}) {
+                const auto &features = plies.back().features[player];
+
+                if (restored.count[player] != plies.back().count[player] or
+                    not std::equal(features.begin(),
+                                   features.begin() + restored.count[player],
+                                   restored.features[player].begin())) {
+                    std::cerr << "unmake_move changed features\n";
+                    exit(1);
+                }
+            }
+
+            verify(game, plies.back());
+        }
+    }
+}
+
+int main() {
+    srand(time(0));
+
+    check_game<TicTacToeGame<Tensor>>(18, 10, 200);
+    check_game<OwareGame<Tensor>>(342, 7, 50);
+
+    std::cerr << "OK\n";
+}
@@ -68,6 +68,10 @@ for (int i = 0; i < decoded.size(); i += 2) {
     // mcts.debug_stats();
 
     int timeout = 900;
+    //* reading input and printing move count against limit of turn too
+    const int time_margin = 10;
+    //* no game clock on CodinGame, only limit of one turn
+    TimeManager time(-1, timeout);
     while (true) {
         temp.read();
 
@@ -95,11 +99,8 @@ for (int i = 0; i < decoded.size(); i += 2) {
 
         std::cerr << *game << "\n";
 
-        int iters = 0;
-        while (not watch.timeout()) {
-            mcts.search(model);
-            iters += config.number_of_iterations_per_turn;
-        }
+        time.set_move_time(timeout - time_margin);
+        mcts.search(model, time);
 
         // mcts.debug_stats();
         
@@ -107,8 +108,17 @@ for (int i = 0; i < decoded.size(); i += 2) {
         // auto move = mcts.get_best();
         
 
-        std::cerr << "ITERS: " << iters << "\n";
-        // std::cerr << "HIT:" << model.cache_hit << " MISS:" << model.cache_miss << "\n";
+        const auto analysis = mcts.analyze();
+        std::cerr << "NODES: " << analysis.nodes << " DEPTH: " << analysis.depth
+                  << " SIMS/S: " << analysis.simulations_per_second << "\n";
+        for (const auto& line : analysis.lines) {
+            std::cerr << "PV:";
+            for (const auto& pv_move : line) {
+                std::cerr << " " << pv_move.move;
+            }
+            std::cerr << "\n";
+        }
+        // std::cerr << "HIT:" << model.get_cache()->get_hits() << " MISS:" << model.get_cache()->get_misses() << "\n";
         std::cerr << "TIME: " << watch.elapsed_milliseconds() << "ms\n";
         // std::cerr << "SELECTED MOVE: " << move << " " << msg << "\n";
         
@@ -126,6 +136,9 @@ for (int i = 0; i < decoded.size(); i += 2) {
 
         std::cout.flush();
 
+        //* search during opponent turn, next restore_root stops it
+        mcts.start_pondering(model);
+
         timeout = 90;
     }
 }
\ No newline at end of file
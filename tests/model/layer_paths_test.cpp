@@ -0,0 +1,143 @@
+#include <games/oware.hpp>
+#include <games/tictactoe.hpp>
+#include <model/model.hpp>
+#include <sstream>
+
+#include "../test_utils.hpp"
+
+/*
+    Layers fused by Sequential (activation in kernels, Flatten folded)
+    against plain double precision forward and against the same layers
+    not fused (activation called as function after kernels), in forward
+    and forward_batch.
+*/
+const float tolerance = 1e-4f;
+
+void check_output(const std::vector<double> &expected, const Tensor &output,
+                  const std::string &path) {
+    for (size_t i = 0; i < expected.size(); i++) {
+        const float diff = std::abs(output.get_element(i) - expected[i]);
+        check(diff <= tolerance, path + " differs by " + std::to_string(diff) +
+                                     " at " + std::to_string(i));
+    }
+}
+
+//* hidden layers relu and tanh, output layer without activation
+std::vector<double> reference(const std::vector<LinearLayer *> &layers,
+                              const Tensor &input) {
+    std::vector<double> x(input.size);
+    for (size_t j = 0; j < input.size; j++) {
+        x[j] = input.get_element(j);
+    }
+
+    for (size_t l = 0; l < layers.size(); l++) {
+        const auto &layer = *layers[l];
+        std::vector<double> y(layer.out_features);
+
+        for (size_t i = 0; i < y.size(); i++) {
+            y[i] = layer.bias.get_element(i);
+            for (size_t j = 0; j < x.size(); j++) {
+                y[i] += x[j] * layer.weights[j].get_element(i);
+            }
+
+            if (l == 0) {
+                y[i] = std::max(y[i], 0.0);
+            } else if (l == 1) {
+                y[i] = std::tanh(y[i]);
+            }
+        }
+
+        x = y;
+    }
+
+    return x;
+}
+
+template <class GameT>
+void check_game(int inputs, int outputs, int positions) {
+    auto linear1 = std::make_shared<LinearLayer>(64, activationRELU);
+    auto linear2 = std::make_shared<LinearLayer>(32, activationTANH);
+    auto linear3 = std::make_shared<LinearLayer>(outputs);
+
+    //* Flatten is folded away from forward list of Sequential
+    Model model(std::make_shared<InputLayer>(std::vector<size_t>{
+                    (size_t)inputs}),
+                std::make_shared<FlattenLayer>(), linear1, linear2, linear3);
+    model.fill_random(-0.5, 0.5);
+
+    const std::vector<LinearLayer *> layers = {linear1.get(), linear2.get(),
+                                               linear3.get()};
+
+    //* same layers linked directly, fuse() of Sequential isn't called
+    auto input = std::make_shared<InputLayer>(std::vector<size_t>{
+        (size_t)inputs});
+    auto unfused1 = std::make_shared<LinearLayer>(64, input, activationRELU);
+    auto unfused2 =
+        std::make_shared<LinearLayer>(32, unfused1, activationTANH);
+    auto unfused3 = std::make_shared<LinearLayer>(outputs, unfused2);
+    const std::vector<Layer *> unfused = {unfused1.get(), unfused2.get(),
+                                          unfused3.get()};
+
+    std::stringstream weights;
+    model.save(weights);
+    for (auto *layer : unfused) {
+        layer->load(weights);
+    }
+
+    //* positions of random games
+    std::vector<Tensor> dense;
+    auto game = std::make_shared<GameT>();
+
+    while ((int)dense.size() < positions) {
+        if (game->is_terminal()) {
+            game = std::make_shared<GameT>();
+        }
+
+        dense.emplace_back(game->get_input_shape());
+        game->get_input_for_network(dense.back());
+
+        const auto expected = reference(layers, dense.back());
+
+        model.set_input(dense.back());
+        model.Sequential::forward();
+        check_output(expected, model.get_output(), "fused forward");
+
+        input->get_output() = dense.back();
+        for (auto *layer : unfused) {
+            layer->forward();
+        }
+        check_output(expected, unfused3->get_output(), "unfused forward");
+
+        game->calc_legal_moves();
+        game->make_move(game->legal_moves[rand() % game->legal_moves_cnt]);
+    }
+
+    //* batch isn't multiple of rows block of GEMM kernel
+    for (size_t i = 0; i < dense.size(); i++) {
+        model.get_batch_input(i) = dense[i];
+    }
+    model.Sequential::forward_batch(dense.size());
+
+    input->reserve_batch(dense.size());
+    for (size_t i = 0; i < dense.size(); i++) {
+        input->get_batch_output()[i] = dense[i];
+    }
+    for (auto *layer : unfused) {
+        layer->forward_batch(dense.size());
+    }
+
+    for (size_t i = 0; i < dense.size(); i++) {
+        const auto expected = reference(layers, dense[i]);
+        check_output(expected, model.get_batch_output()[i],
+                     "fused forward_batch");
+        check_output(expected, unfused3->get_batch_output()[i],
+                     "unfused forward_batch");
+    }
+}
+
+int main() {
+    check_game<TicTacToeGame<Tensor>>(18, 10, 29);
+    check_game<OwareGame<Tensor>>(342, 7, 61);
+
+    std::cerr << "OK\n";
+}
@@ -88,8 +88,8 @@ int main() {
         const int move = mcts.get_best();
 
         std::cerr << "ITERS: " << iters << "\n";
-        // std::cerr << "HIT:" << model.cache_hit << " MISS:" <<
-        // model.cache_miss << "\n";
+        // std::cerr << "HIT:" << model.get_cache()->get_hits() << " MISS:"
+        // << model.get_cache()->get_misses() << "\n";
         std::cerr << "TIME: " << watch.elapsed_milliseconds() << "ms\n";
 
         game->make_move(move);
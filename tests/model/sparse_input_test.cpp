@@ -0,0 +1,52 @@
+#include <games/oware.hpp>
+#include <games/tictactoe.hpp>
+#include <model/model.hpp>
+
+#include "../test_utils.hpp"
+
+//* sparse input set by set_input(game) against dense input of the game
+const float tolerance = 1e-5f;
+
+template <class GameT>
+void check_game(int inputs, int outputs, int positions) {
+    Model model = make_model(inputs, outputs);
+
+    auto game = std::make_shared<GameT>();
+    Tensor dense(game->get_input_shape());
+
+    for (int i = 0; i < positions; i++) {
+        if (game->is_terminal()) {
+            game = std::make_shared<GameT>();
+        }
+
+        game->get_input_for_network(dense);
+
+        model.set_input(dense);
+        model.Sequential::forward();
+        const Tensor expected = model.get_output();
+
+        model.set_input(*game);
+        check(model.get_input_layer().sparse, "game has no sparse input");
+        model.Sequential::forward();
+        model.get_input_layer().sparse = false;
+
+        for (size_t j = 0; j < expected.size; j++) {
+            const float diff = std::abs(model.get_output().get_element(j) -
+                                        expected.get_element(j));
+            check(diff <= tolerance,
+                  "sparse forward differs by " + std::to_string(diff) +
+                      " at " + std::to_string(j) + " of position " +
+                      std::to_string(i));
+        }
+
+        game->calc_legal_moves();
+        game->make_move(game->legal_moves[rand() % game->legal_moves_cnt]);
+    }
+}
+
+int main() {
+    check_game<TicTacToeGame<Tensor>>(18, 10, 29);
+    check_game<OwareGame<Tensor>>(342, 7, 61);
+
+    std::cerr << "OK\n";
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <model/model.hpp>
+#include <string>
+
+//* helpers shared by tests, every test is executable returning 0 if OK
+
+inline void check(bool ok, const std::string &msg) {
+    if (not ok) {
+        std::cerr << msg << "\n";
+        exit(1);
+    }
+}
+
+//* small network with random weights, enough for search to be non uniform
+inline Model make_model(int inputs, int outputs) {
+    Model model(std::make_shared<InputLayer>(std::vector<size_t>{
+                    (size_t)inputs}),
+                std::make_shared<LinearLayer>(32, activationRELU),
+                std::make_shared<LinearLayer>(outputs));
+    model.fill_random(-0.1, 0.1);
+
+    return model;
+}
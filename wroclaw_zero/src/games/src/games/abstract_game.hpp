@@ -9,7 +9,42 @@ class AbstractGame {
    public:
     virtual void calc_legal_moves() = 0;
     virtual void make_move(int move_id) = 0;
+
+    /*
+        State stack used to walk the tree without cloning:
+        push_state(); make_move(move); ... unmake_move();
+    */
+    virtual void push_state() = 0;
+    virtual void unmake_move() = 0;
+
     virtual void get_input_for_network(Tensor& input) const = 0;
+
+    /*
+        Input as active features for incremental first layer (see
+        Accumulator): sorted indices of ones set by get_input_for_network
+        if player (0 or 1) was to move, lists of both players change
+        little by one move. Returns their count, -1 if game has other
+        input.
+    */
+    virtual int get_active_features(int player, int* features) const {
+        return -1;
+    }
+
+    virtual int get_player_to_move() const { return 0; }
+
+    /*
+        Sparse get_input_for_network, without fill of whole input. One-hot
+        inputs are active features of player to move. Returns false if
+        game has only dense input.
+    */
+    virtual bool get_sparse_input_for_network(
+        typename Tensor::Sparse& input) const {
+        input.count =
+            get_active_features(get_player_to_move(), input.indices.data());
+        input.values.clear();
+
+        return input.count >= 0;
+    }
     virtual std::vector<size_t> get_input_shape() const = 0;
     virtual int get_maximum_number_of_turns() const = 0;
     virtual int get_turn_number() const = 0;
@@ -35,4 +70,49 @@ class AbstractGame {
             legal_moves[legal_moves_cnt++] = move;
         }
     }
-};
\ No newline at end of file
+};
+/*
+    Helpers letting search code hold game state either type-erased
+    (std::shared_ptr<AbstractGame>) or by value as concrete final game,
+    in which case calls are resolved statically and can be inlined.
+*/
+template <class Game>
+inline Game& game_ref(Game& game) {
+    return game;
+}
+
+template <class Game>
+inline const Game& game_ref(const Game& game) {
+    return game;
+}
+
+template <class Game>
+inline Game& game_ref(std::shared_ptr<Game>& game) {
+    return *game;
+}
+
+template <class Game>
+inline const Game& game_ref(const std::shared_ptr<Game>& game) {
+    return *game;
+}
+
+template <class Game>
+inline Game clone_game(const Game& game) {
+    return game;
+}
+
+template <class Game>
+inline std::shared_ptr<Game> clone_game(const std::shared_ptr<Game>& game) {
+    return game->clone();
+}
+
+template <class Game>
+inline bool equal_games(const Game& a, const Game& b) {
+    return a.equal(b);
+}
+
+template <class Game>
+inline bool equal_games(const std::shared_ptr<Game>& a,
+                        const std::shared_ptr<Game>& b) {
+    return a->equal(b);
+}
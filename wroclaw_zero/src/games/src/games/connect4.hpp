@@ -8,7 +8,7 @@
 #include "abstract_game.hpp"
 
 template <class Tensor>
-class Connect4Game : public AbstractGame<Tensor> {
+class Connect4Game final : public AbstractGame<Tensor> {
    public:
     static inline constexpr int WIDTH = 9;
     static inline constexpr int HEIGHT = 7;
@@ -198,10 +198,48 @@ class Connect4Game : public AbstractGame<Tensor> {
         }
     }
 
+    //* planes of get_input_for_network, my discs first
+    bool get_sparse_input_for_network(
+        typename Tensor::Sparse& input) const override {
+        input.count = 0;
+        input.values.clear();
+
+        const uint64_t planes[2] = {my_mask_, opp_mask_};
+
+        for (int plane = 0; plane < 2; plane++) {
+            for (int x = 0; x < WIDTH; x++) {
+                for (int y = 0; y < HEIGHT; y++) {
+                    if (planes[plane] & get_cell_mask(x, y)) {
+                        input.indices[input.count++] =
+                            (plane * WIDTH + x) * HEIGHT + y;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
     std::vector<size_t> get_input_shape() const override {
         return std::vector<size_t>{2, WIDTH, HEIGHT};
     }
 
+    void push_state() override {
+        history_.push_back(
+            State{my_mask_, opp_mask_, cells_empty_, turn_, game_ended_});
+    }
+
+    void unmake_move() override {
+        assert(not history_.empty());
+        const auto& state = history_.back();
+        my_mask_ = state.my_mask;
+        opp_mask_ = state.opp_mask;
+        cells_empty_ = state.cells_empty;
+        turn_ = state.turn;
+        game_ended_ = state.game_ended;
+        history_.pop_back();
+    }
+
     std::shared_ptr<AbstractGame<Tensor>> clone() const override {
         std::shared_ptr<AbstractGame<Tensor>> it =
             std::make_shared<Connect4Game<Tensor>>(*this);
@@ -216,22 +254,42 @@ class Connect4Game : public AbstractGame<Tensor> {
     }
 
     uint64_t calc_hash() const {
-        abort();
-        return 0;
+        // masks use 63 bits, last one for player to move
+        const uint64_t opp = opp_mask_ | (uint64_t)(turn_ & 1) << 63;
+
+        uint64_t lower_hash = splittable64(my_mask_);
+        uint64_t upper_hash = splittable64(opp);
+
+        uint64_t rotated_upper = upper_hash << 31 | upper_hash >> 33;
+        return lower_hash ^ rotated_upper;
     }
 
     bool equal(
         const std::shared_ptr<AbstractGame<Tensor>>& other) const override {
         if (Connect4Game<Tensor>* ptr =
                 dynamic_cast<Connect4Game<Tensor>*>(other.get())) {
-            return my_mask_ == ptr->my_mask_ and opp_mask_ == ptr->opp_mask_ and
-                   cells_empty_ == ptr->cells_empty_ and turn_ == ptr->turn_ and
-                   game_ended_ == ptr->game_ended_;
+            return equal(*ptr);
         }
 
         return false;
     }
 
+    bool equal(const Connect4Game& other) const {
+        return my_mask_ == other.my_mask_ and opp_mask_ == other.opp_mask_ and
+               cells_empty_ == other.cells_empty_ and turn_ == other.turn_ and
+               game_ended_ == other.game_ended_;
+    }
+
+   private:
+    inline uint64_t splittable64(uint64_t x) const {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
    public:
     inline uint64_t get_cell_id(int x, int y) const { return x * HEIGHT + y; }
 
@@ -331,4 +389,14 @@ class Connect4Game : public AbstractGame<Tensor> {
     uint32_t cells_empty_;
     uint16_t turn_;
     uint16_t game_ended_;
+
+   private:
+    struct State {
+        uint64_t my_mask, opp_mask;
+        uint32_t cells_empty;
+        uint16_t turn;
+        uint16_t game_ended;
+    };
+
+    std::vector<State> history_;
 };
\ No newline at end of file
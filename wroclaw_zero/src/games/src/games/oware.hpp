@@ -1,12 +1,13 @@
 #pragma once
 
+#include <array>
 #include <cassert>
 #include <iostream>
 
 #include "abstract_game.hpp"
 
 template <class Tensor>
-class OwareGame : public AbstractGame<Tensor> {
+class OwareGame final : public AbstractGame<Tensor> {
    public:
     OwareGame() { reset(); }
 
@@ -314,10 +315,50 @@ class OwareGame : public AbstractGame<Tensor> {
         // return input;
     }
 
+    //* same indices as get_input_for_network
+    int get_active_features(int player, int* features) const override {
+        const uint8_t* my_cells = (player == 0 ? &cell0_[0] : &cell1_[0]);
+        const uint8_t* enemy_cells = (player == 0 ? &cell1_[0] : &cell0_[0]);
+        const uint8_t my_score = (player == 0 ? score0_ : score1_);
+        const uint8_t enemy_score = (player == 0 ? score1_ : score0_);
+        int cnt = 0;
+
+        for (int i = 0; i < 6; i++) {
+            features[cnt++] = 24 * i + (my_cells[i] > 23 ? 23 : my_cells[i]);
+        }
+
+        for (int i = 0; i < 6; i++) {
+            features[cnt++] =
+                24 * (i + 6) + (enemy_cells[i] > 23 ? 23 : enemy_cells[i]);
+        }
+
+        const int offset = 24 * 12;
+        features[cnt++] = offset + (my_score > 26 ? 26 : my_score);
+
+        //* ranges of scores share one index, input has it set once
+        const int enemy = offset + 26 + (enemy_score > 26 ? 26 : enemy_score);
+        if (enemy != features[cnt - 1]) {
+            features[cnt++] = enemy;
+        }
+
+        return cnt;
+    }
+
+    int get_player_to_move() const override { return id_to_play_; }
+
     std::vector<size_t> get_input_shape() const override {
         return std::vector<size_t>{24 * 12 + 2 * 27};
     }
 
+    void push_state() override { history_.push_back({state_[0], state_[1]}); }
+
+    void unmake_move() override {
+        assert(not history_.empty());
+        state_[0] = history_.back()[0];
+        state_[1] = history_.back()[1];
+        history_.pop_back();
+    }
+
     std::shared_ptr<AbstractGame<Tensor>> clone() const override {
         std::shared_ptr<AbstractGame<Tensor>> it =
             std::make_shared<OwareGame<Tensor>>(*this);
@@ -380,12 +421,16 @@ class OwareGame : public AbstractGame<Tensor> {
         const std::shared_ptr<AbstractGame<Tensor>>& other) const override {
         if (OwareGame<Tensor>* ptr =
                 dynamic_cast<OwareGame<Tensor>*>(other.get())) {
-            return state_[0] == ptr->state_[0] and state_[1] == ptr->state_[1];
+            return equal(*ptr);
         }
 
         return false;
     }
 
+    bool equal(const OwareGame& other) const {
+        return state_[0] == other.state_[0] and state_[1] == other.state_[1];
+    }
+
    private:
     inline uint64_t splittable64(uint64_t x) const {
         x ^= x >> 30;
@@ -444,4 +489,6 @@ class OwareGame : public AbstractGame<Tensor> {
             uint8_t cell1_[6];
         };
     };
+
+    std::vector<std::array<uint64_t, 2>> history_;
 };
\ No newline at end of file
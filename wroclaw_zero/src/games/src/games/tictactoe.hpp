@@ -7,7 +7,7 @@
 #include "abstract_game.hpp"
 
 template <class Tensor>
-class TicTacToeGame : public AbstractGame<Tensor> {
+class TicTacToeGame final : public AbstractGame<Tensor> {
    public:
     TicTacToeGame()
         : mask({0, 0}), current_player(0), status(-1), moves_cnt(0) {}
@@ -63,6 +63,26 @@ class TicTacToeGame : public AbstractGame<Tensor> {
         // return input;
     }
 
+    int get_active_features(int player, int* features) const override {
+        int cnt = 0;
+
+        for (int i = 0; i < 9; i++) {
+            if (mask[player] & (1 << i)) {
+                features[cnt++] = i;
+            }
+        }
+
+        for (int i = 0; i < 9; i++) {
+            if (mask[1 ^ player] & (1 << i)) {
+                features[cnt++] = 9 + i;
+            }
+        }
+
+        return cnt;
+    }
+
+    int get_player_to_move() const override { return current_player; }
+
     std::vector<size_t> get_input_shape() const override {
         return std::vector<size_t>{18};
     }
@@ -83,6 +103,20 @@ class TicTacToeGame : public AbstractGame<Tensor> {
 
     int get_maximum_number_of_moves() const override { return 9; }
 
+    void push_state() override {
+        history_.push_back(State{mask, current_player, status, moves_cnt});
+    }
+
+    void unmake_move() override {
+        assert(not history_.empty());
+        const auto& state = history_.back();
+        mask = state.mask;
+        current_player = state.current_player;
+        status = state.status;
+        moves_cnt = state.moves_cnt;
+        history_.pop_back();
+    }
+
     std::shared_ptr<AbstractGame<Tensor>> clone() const override {
         std::shared_ptr<AbstractGame<Tensor>> it =
             std::make_shared<TicTacToeGame<Tensor>>(*this);
@@ -93,12 +127,16 @@ class TicTacToeGame : public AbstractGame<Tensor> {
         const std::shared_ptr<AbstractGame<Tensor>>& other) const override {
         if (TicTacToeGame<Tensor>* ptr =
                 dynamic_cast<TicTacToeGame<Tensor>*>(other.get())) {
-            return mask == ptr->mask and current_player == ptr->current_player;
+            return equal(*ptr);
         }
 
         return false;
     }
 
+    bool equal(const TicTacToeGame& other) const {
+        return mask == other.mask and current_player == other.current_player;
+    }
+
     friend std::ostream& operator<<(std::ostream& os,
                                     const TicTacToeGame& game) {
         for (int i = 0; i < 9; i++) {
@@ -121,7 +159,10 @@ class TicTacToeGame : public AbstractGame<Tensor> {
 
     float eval() const { return 0; }
 
-    uint64_t calc_hash() const { return 0; }
+    uint64_t calc_hash() const {
+        return (uint64_t)mask[0] | (uint64_t)mask[1] << 9 |
+               (uint64_t)current_player << 18;
+    }
 
    public:
     std::array<int, 2> mask;
@@ -133,4 +174,14 @@ class TicTacToeGame : public AbstractGame<Tensor> {
     static inline const std::array<int, 8> winning_masks = {
         0b111'000'000, 0b000'111'000, 0b000'000'111, 0b100'100'100,
         0b010'010'010, 0b001'001'001, 0b100'010'001, 0b001'010'100};
+
+   private:
+    struct State {
+        std::array<int, 2> mask;
+        int current_player;
+        int status;
+        int moves_cnt;
+    };
+
+    std::vector<State> history_;
 };
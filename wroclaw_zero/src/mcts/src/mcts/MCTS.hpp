@@ -1,21 +1,35 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <functional>
 #include <games/abstract_game.hpp>
 #include <iomanip>
+#include <limits>
 #include <memory>
 #include <model/model.hpp>
+#include <mutex>
 #include <random>
 #include <set>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "MCTS_compact_nodes.hpp"
 #include "MCTS_config.hpp"
 #include "MCTS_node.hpp"
+#include "MCTS_soa_nodes.hpp"
 #include "random.hpp"
 #include "sample.hpp"
+#include "search_analysis.hpp"
 #include "stopwatch.hpp"
+#include "time_manager.hpp"
+#include "transposition_table.hpp"
 
 // TODO: move this to some utils or sth
 inline float fastlogf(const float &x) {
@@ -47,93 +61,591 @@ inline float fastsqrtf(const float &x) {
     return (u.x);
 }
 
+//* atomic add for tree-parallel search, plain add otherwise
+template <bool concurrent>
+inline void add_to(int &x, int val) {
+    if constexpr (concurrent) {
+        __atomic_fetch_add(&x, val, __ATOMIC_RELAXED);
+    } else {
+        x += val;
+    }
+}
+
+template <bool concurrent>
+inline void add_to(float &x, float val) {
+    if constexpr (concurrent) {
+        float expected, desired;
+        __atomic_load(&x, &expected, __ATOMIC_RELAXED);
+
+        do {
+            desired = expected + val;
+        } while (not __atomic_compare_exchange(&x, &expected, &desired, true,
+                                               __ATOMIC_RELAXED,
+                                               __ATOMIC_RELAXED));
+    } else {
+        x += val;
+    }
+}
+
+/*
+    child_count publishes children block in tree-parallel search,
+    children are written before release store of child_count
+*/
+template <class Int>
+inline int load_child_count(const Int &child_count) {
+    return __atomic_load_n(&child_count, __ATOMIC_ACQUIRE);
+}
+
+template <class Int>
+inline void store_child_count(Int &child_count, int val) {
+    __atomic_store_n(&child_count, val, __ATOMIC_RELEASE);
+}
+
+template <class Int>
+inline bool claim_child_count(Int &child_count, int expected, int desired) {
+    return __atomic_compare_exchange_n(&child_count, &expected, desired, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
 using Game = std::shared_ptr<AbstractGame<Tensor>>;
 
-class MCTS {
+/*
+    define MCTS_SOA_NODES to store nodes as structure of arrays,
+    MCTS_COMPACT_NODES to store packed 20 byte nodes (single threaded only)
+*/
+#if defined(MCTS_SOA_NODES) and defined(MCTS_COMPACT_NODES)
+#error "MCTS_SOA_NODES and MCTS_COMPACT_NODES are exclusive"
+#endif
+
+#ifdef MCTS_SOA_NODES
+using MCTSNodes = MCTSSoANodes;
+#elif defined(MCTS_COMPACT_NODES)
+using MCTSNodes = MCTSCompactNodes;
+#else
+using MCTSNodes = std::vector<MCTSNode>;
+#endif
+
+/*
+    GameState is either Game (type-erased, used by configuration driven code)
+    or concrete final game held by value, e.g. BasicMCTS<OwareGame<Tensor>>.
+    With concrete game every game call in search loop is resolved at compile
+    time and can be inlined.
+    Tree is owned by pondering thread while it runs: every method reading
+    or changing tree stops pondering first, except const methods
+    (analyze(), get_root_state() and counters), which require it stopped.
+*/
+template <class GameState>
+class BasicMCTS {
+    //* type of game behind GameState, AbstractGame<Tensor> for Game
+    using GameType = std::remove_const_t<std::remove_reference_t<decltype(
+        game_ref(std::declval<GameState &>()))>>;
+
    public:
-    MCTS(const Game &gamestate, MCTSConfig config) : config_(config) {
-        root_gamestate_ = gamestate->clone();
+    BasicMCTS(const GameState &gamestate, MCTSConfig config)
+        : config_(config) {
+        root_gamestate_ = clone_game(gamestate);
 
         nodes_.resize(1);
-        if (config.init_reserved_nodes > 0) {
+        if (config.max_nodes > 0) {
+            //* whole budget once, vectors never double past it, compact()
+            //* swaps edges with its buffer, so both are reserved
+            nodes_.reserve(node_budget());
+            compact_buffer_.reserve(node_budget());
+            if (config.lazy_children) {
+                edges_.reserve(node_budget());
+                compact_edges_.reserve(node_budget());
+            }
+        } else if (config.init_reserved_nodes > 0) {
             nodes_.reserve(config.init_reserved_nodes);
         }
         root_idx_ = 0;
         nodes_count_ = 1;
+        edges_count_ = 0;
+        root_ply_ = 0;
+        abandoned_visits_ = 0;
+        saved_simulations_ = 0;
+        last_simulations_ = 0;
+        last_search_us_ = 0;
+        forced_root_child_ = -1;
+        gumbel_move_ = -1;
+        transpositions_.resize(config.transposition_table_size);
+        pondering_ = false;
+        ponder_simulations_ = 0;
     }
 
-    void reset(const Game &gamestate) {
-        root_gamestate_ = gamestate->clone();
+    ~BasicMCTS() { stop_pondering(); }
+
+    void reset(const GameState &gamestate) {
+        stop_pondering();
+        root_gamestate_ = clone_game(gamestate);
         nodes_[0] = MCTSNode();
         root_idx_ = 0;
         nodes_count_ = 1;
+        edges_count_ = 0;
+        root_ply_ = 0;
+        abandoned_visits_ = 0;
+        solved_children_.clear();
+        gumbel_move_ = -1;
+        transpositions_.clear();
+        scratch_.valid = false;
     }
 
     void search(Model &model) {
+        stop_pondering();
+        SearchMeter meter(*this);
+        saved_simulations_ = 0;
+        gumbel_move_ = -1;
+
         if (nodes_[root_idx_].is_solved()) {
             return;
         }
 
-        for (int i = 0; i < config_.number_of_iterations_per_turn; i++) {
+        const int iterations = config_.number_of_iterations_per_turn;
+
+        if (config_.gumbel) {
+            gumbel_search(model, iterations);
+            return;
+        }
+
+        //* search stops as soon as root is proven, more iterations can't
+        //* change the result
+        if (config_.batch_size > 1) {
+            for (int i = 0;
+                 i < iterations and not nodes_[root_idx_].is_solved() and
+                 not can_stop_early(iterations - i);) {
+                const int leaves =
+                    std::min(config_.batch_size, iterations - i);
+
+                i += update_batch(model, leaves);
+            }
+
+            return;
+        }
+
+        for (int i = 0; i < iterations and not nodes_[root_idx_].is_solved() and
+                        not can_stop_early(iterations - i);
+             i++) {
             update(model);
         }
     }
 
+    //* Gumbel root search needs known budget, timed search is always PUCT
     void search(Model &model, int ms) {
+        stop_pondering();
+        SearchMeter meter(*this);
+        saved_simulations_ = 0;
+        gumbel_move_ = -1;
+
         if (nodes_[root_idx_].is_solved()) {
             return;
         }
 
         Stopwatch watch(ms);
 
+        if (config_.batch_size > 1) {
+            for (int i = 0; not watch.timeout() and
+                            not nodes_[root_idx_].is_solved() and
+                            not can_stop_early(
+                                remaining_simulations(watch, ms, i));) {
+                i += update_batch(model, config_.batch_size);
+            }
+
+            return;
+        }
+
         for (int i = 0; i % 10 or not watch.timeout(); i++) {
+            if (nodes_[root_idx_].is_solved()) {
+                break;
+            }
+
+            if (i % 10 == 0 and
+                can_stop_early(remaining_simulations(watch, ms, i))) {
+                break;
+            }
+
+            update(model);
+        }
+    }
+
+    /*
+        Timed search with budget of time manager. Solved root and single
+        legal move take no time, otherwise search stops at optimal time if
+        best move didn't change since last check and two best moves have
+        different values, or at maximum time.
+    */
+    void search(Model &model, TimeManager &time) {
+        stop_pondering();
+        SearchMeter meter(*this);
+        Stopwatch watch(0);
+        saved_simulations_ = 0;
+        gumbel_move_ = -1;
+
+        if (nodes_[root_idx_].child_count == 0 and
+            not nodes_[root_idx_].is_solved()) {
             update(model);
         }
+
+        if (nodes_[root_idx_].is_solved() or
+            nodes_[root_idx_].child_count == 1) {
+            time.spent(watch.elapsed_milliseconds());
+            return;
+        }
+
+        const int check_every = std::max(1, time.optimal_time() / 10);
+        long long next_check = check_every;
+        int best_child = most_visited_root_child();
+
+        for (int i = 0; not nodes_[root_idx_].is_solved();) {
+            if (config_.batch_size > 1) {
+                i += update_batch(model, config_.batch_size);
+            } else {
+                update(model);
+                i++;
+            }
+
+            const long long elapsed = watch.elapsed_milliseconds();
+
+            if (elapsed < next_check) {
+                continue;
+            }
+
+            next_check = elapsed + check_every;
+
+            const int current = most_visited_root_child();
+            const bool changed = current != best_child;
+            best_child = current;
+
+            if (time.can_stop(elapsed, changed, root_q_gap()) or
+                can_stop_early(
+                    remaining_simulations(watch, time.maximum_time(), i))) {
+                break;
+            }
+        }
+
+        time.spent(watch.elapsed_milliseconds());
+    }
+
+    /*
+        Tree-parallel search, one thread per model. All threads descend the
+        same tree, statistics are updated atomically and virtual loss keeps
+        threads on different paths.
+    */
+    void search(std::vector<Model> &models) {
+        stop_pondering();
+        SearchMeter meter(*this);
+#ifdef MCTS_COMPACT_NODES
+        //* packed nodes can't be updated atomically
+        search(models[0]);
+#else
+        //* sequential halving forces root moves one by one, single thread
+        if (models.size() == 1 or config_.gumbel) {
+            search(models[0]);
+            return;
+        }
+
+        search_concurrent(models, config_.number_of_iterations_per_turn, -1);
+#endif
+    }
+
+    void search(std::vector<Model> &models, int ms) {
+        stop_pondering();
+        SearchMeter meter(*this);
+#ifdef MCTS_COMPACT_NODES
+        //* packed nodes can't be updated atomically
+        search(models[0], ms);
+#else
+        if (models.size() == 1) {
+            search(models[0], ms);
+            return;
+        }
+
+        search_concurrent(models, -1, ms);
+#endif
+    }
+
+    /*
+        Tree-parallel search with budget of time manager, the calling
+        thread checks the same stop rule as single threaded timed search
+        while threads search.
+    */
+    void search(std::vector<Model> &models, TimeManager &time) {
+        stop_pondering();
+        SearchMeter meter(*this);
+#ifdef MCTS_COMPACT_NODES
+        //* packed nodes can't be updated atomically
+        search(models[0], time);
+#else
+        if (models.size() == 1) {
+            search(models[0], time);
+            return;
+        }
+
+        Stopwatch watch(0);
+
+        if (nodes_[root_idx_].child_count == 0 and
+            not nodes_[root_idx_].is_solved()) {
+            update(models[0]);
+        }
+
+        if (nodes_[root_idx_].is_solved() or
+            nodes_[root_idx_].child_count == 1) {
+            saved_simulations_ = 0;
+            gumbel_move_ = -1;
+            time.spent(watch.elapsed_milliseconds());
+            return;
+        }
+
+        search_concurrent(models, -1, time.maximum_time(), &time);
+        time.spent(watch.elapsed_milliseconds());
+#endif
     }
 
     void restore_root(int move, Model &model) {
-        auto &root = nodes_[root_idx_];
+        stop_pondering();
+        auto &&root = nodes_[root_idx_];
 
         for (int i = 0; i < root.child_count; i++) {
             const int child_idx = root.child_index + i;
-            auto &child = nodes_[child_idx];
+            auto &&child = nodes_[child_idx];
 
             if (child.move == move) {
+                abandon_root(child.visits);
                 root_idx_ = child_idx;
-                root_gamestate_->make_move(move);
+                game_ref(root_gamestate_).make_move(move);
+                root_ply_++;
+                gumbel_move_ = -1;
+                scratch_.valid = false;
+                materialize_children(root_idx_);
+                maybe_compact();
                 return;
             }
         }
 
-        root_gamestate_->make_move(move);
+        game_ref(root_gamestate_).make_move(move);
         reset(root_gamestate_);
     }
 
-    void restore_root(const Game &gamestate, Model &model) {
-        auto &root = nodes_[root_idx_];
+    void restore_root(const GameState &gamestate, Model &model) {
+        stop_pondering();
+        auto &&root = nodes_[root_idx_];
 
         for (int i = 0; i < root.child_count; i++) {
             const int child_idx = root.child_index + i;
-            auto &child = nodes_[child_idx];
+            auto &&child = nodes_[child_idx];
 
-            auto temp = root_gamestate_->clone();
-            temp->make_move(child.move);
+            auto temp = clone_game(root_gamestate_);
+            game_ref(temp).make_move(child.move);
 
-            if (temp->equal(gamestate)) {
+            if (equal_games(temp, gamestate)) {
+                abandon_root(child.visits);
                 root_idx_ = child_idx;
-                root_gamestate_->make_move(child.move);
+                game_ref(root_gamestate_).make_move(child.move);
+                root_ply_++;
+                gumbel_move_ = -1;
+                scratch_.valid = false;
+                materialize_children(root_idx_);
+                maybe_compact();
                 return;
             }
         }
 
-        expansion(root_idx_, root_gamestate_, model);
+        expansion(root_idx_, game_ref(root_gamestate_), model);
 
         reset(gamestate);
     }
 
-    const Game &get_root_state() const { return root_gamestate_; }
+    /*
+        Pondering, keeps searching from current root on background thread
+        while opponent thinks. Model belongs to that thread (and has to
+        outlive it) until pondering is stopped, restore_root, reset, search,
+        get_best, get_sample, debug output and destructor stop it on their
+        own.
+        Pondering stops when tree reaches max_nodes budget or reserved
+        init_reserved_nodes, so it never prunes or reallocates nodes, and
+        without them at ponder_max_nodes.
+    */
+    void start_pondering(Model &model) {
+        stop_pondering();
+
+        if (nodes_[root_idx_].is_solved()) {
+            return;
+        }
+
+        pondering_ = true;
+        ponder_simulations_ = 0;
+
+        //* nodes one update can add at most
+        const size_t update_nodes =
+            (size_t)game_ref(root_gamestate_).get_maximum_number_of_moves() *
+            std::max(1, config_.batch_size);
+        size_t max_nodes = ponder_max_nodes;
+        if (config_.max_nodes > 0) {
+            max_nodes = node_budget();
+        } else if (config_.init_reserved_nodes > 0) {
+            max_nodes = nodes_.capacity();
+        }
+
+        ponder_thread_ = std::thread([this, &model, update_nodes, max_nodes]() {
+            while (pondering_ and not nodes_[root_idx_].is_solved() and
+                   nodes_count_ + update_nodes <= max_nodes and
+                   edges_count_ + update_nodes <= max_nodes) {
+                if (config_.batch_size > 1) {
+                    ponder_simulations_ +=
+                        update_batch(model, config_.batch_size);
+                } else {
+                    update(model);
+                    ponder_simulations_++;
+                }
+            }
+        });
+    }
+
+    //* limit of pondering without max_nodes and init_reserved_nodes
+    static constexpr size_t ponder_max_nodes = 1'000'000;
+
+    //* returns number of simulations done by pondering
+    int stop_pondering() {
+        if (not ponder_thread_.joinable()) {
+            return 0;
+        }
+
+        pondering_ = false;
+        ponder_thread_.join();
+
+        return ponder_simulations_;
+    }
+
+    //* thread is joined only by stop_pondering(), even if it ended itself
+    bool is_pondering() const { return ponder_thread_.joinable(); }
+
+    const GameState &get_root_state() const {
+        assert(not is_pondering() and "stop_pondering() before reading root");
+        return root_gamestate_;
+    }
+
+    size_t get_nodes_count() const {
+        assert(not is_pondering() and "stop_pondering() before reading tree");
+        return nodes_count_;
+    }
+
+    size_t get_edges_count() const {
+        assert(not is_pondering() and "stop_pondering() before reading tree");
+        return edges_count_;
+    }
+
+    //* budget of next searches, playout cap randomization changes it per move
+    void set_iterations_per_turn(int iterations) {
+        stop_pondering();
+        config_.number_of_iterations_per_turn = iterations;
+    }
+
+    //* simulations skipped by smart stop in last search, estimated in timed
+    int get_saved_simulations() const {
+        assert(not is_pondering() and "stop_pondering() before reading stats");
+        return saved_simulations_;
+    }
+
+    /*
+        Moves subtree of current root to the front of nodes_ in BFS order
+        and drops everything else. Blocks shared by transpositions are
+        copied once. Children of unsolved nodes below root with less than
+        min_visits visits are pruned, such node becomes leaf again and
+        keeps its own statistics. Must not be called during search.
+    */
+    void compact(int min_visits = 0) {
+        constexpr uint32_t REMOVED = UINT32_MAX;
+
+        node_remap_.assign(nodes_count_, REMOVED);
+        edge_remap_.assign(edges_count_, REMOVED);
+        compact_buffer_.clear();
+        compact_edges_.clear();
+
+        compact_buffer_.push_back(nodes_[root_idx_]);
+
+        for (size_t i = 0; i < compact_buffer_.size(); i++) {
+            const int child_count = compact_buffer_[i].child_count;
+            const uint32_t old_index = compact_buffer_[i].child_index;
+
+            if (child_count <= 0) {
+                continue;
+            }
+
+            if (i > 0 and compact_buffer_[i].visits < min_visits and
+                not compact_buffer_[i].is_solved()) {
+                prune_children(compact_buffer_[i]);
+                continue;
+            }
+
+            if (compact_buffer_[i].child_index < 0) {
+                compact_lazy_block(i);
+                continue;
+            }
+
+            //* block was already copied by transposition
+            if (old_index != root_idx_ and node_remap_[old_index] != REMOVED) {
+                compact_buffer_[i].child_index = node_remap_[old_index];
+                continue;
+            }
+
+            compact_buffer_[i].child_index = compact_buffer_.size();
+
+            for (int j = 0; j < child_count; j++) {
+                node_remap_[old_index + j] = compact_buffer_.size();
+                compact_buffer_.push_back(nodes_[old_index + j]);
+            }
+        }
+
+        if (transpositions_.enabled()) {
+            const uint32_t old_root = root_idx_;
+
+            transpositions_.remap([&](uint32_t node_idx) -> int64_t {
+                if (node_idx == old_root) {
+                    return 0;
+                }
+
+                if (node_idx >= node_remap_.size() or
+                    node_remap_[node_idx] == REMOVED) {
+                    return -1;
+                }
+
+                return node_remap_[node_idx];
+            });
+        }
+
+        for (size_t i = 0; i < compact_buffer_.size(); i++) {
+            nodes_[i] = compact_buffer_[i];
+        }
+
+        root_idx_ = 0;
+        nodes_count_ = compact_buffer_.size();
+        edges_.swap(compact_edges_);
+        edges_count_ = edges_.size();
+        abandoned_visits_ = 0;
+        compact_solved_children(REMOVED);
+        scratch_.valid = false;
+    }
+
+    //* compact() step, counters move with their nodes, pruned nodes lose them
+    void compact_solved_children(uint32_t removed) {
+        const size_t count =
+            std::min(solved_children_.size(), node_remap_.size());
+        compact_solved_children_.assign(compact_buffer_.size(),
+                                        SolvedChildren());
+
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t idx = i == root_idx_ ? 0 : node_remap_[i];
+
+            if (idx != removed and compact_buffer_[idx].child_count > 0) {
+                compact_solved_children_[idx] = solved_children_[i];
+            }
+        }
+
+        solved_children_.swap(compact_solved_children_);
+    }
 
     int get_best(bool debug = false) {
+        stop_pondering();
+
         const auto &root = nodes_[root_idx_];
 
         assert(root.child_count > 0);
@@ -169,6 +681,11 @@ class MCTS {
             return best_move;
         }
 
+        //* Gumbel noise already made the choice random, no temperature
+        if (gumbel_move_ != -1) {
+            return gumbel_move_;
+        }
+
         std::vector<float> pi(root.child_count);
 
         for (int i = 0; i < root.child_count; i++) {
@@ -185,7 +702,7 @@ class MCTS {
             //           << "\n";
         }
 
-        const int turn = root_gamestate_->get_turn_number();
+        const int turn = game_ref(root_gamestate_).get_turn_number();
 
         if (turn < config_.temperature_turns) {
             float temperature = config_.temperature_max;
@@ -244,6 +761,8 @@ class MCTS {
     }
 
     std::pair<int, std::string> get_cg_best() {
+        stop_pondering();
+
         const int best_move = get_best(true);
 
         const auto &root = nodes_[root_idx_];
@@ -271,8 +790,10 @@ class MCTS {
     }
 
     void get_sample(Sample &sample) {
-        // sample.input = Tensor(root_gamestate_->get_input_shape());
-        root_gamestate_->get_input_for_network(sample.input);
+        stop_pondering();
+
+        // sample.input = Tensor(game_ref(root_gamestate_).get_input_shape());
+        game_ref(root_gamestate_).get_input_for_network(sample.input);
 
         //* sample score = <final result> * K + <avg MCTS score> * (1 - K)
         sample.score = nodes_[root_idx_].get_value();
@@ -287,7 +808,7 @@ class MCTS {
             sample.legal_moves[node.move] = 1;
         }
 
-        // sample.policy.resize(root_gamestate_->get_maximum_number_of_moves());
+        // sample.policy.resize(game_ref(root_gamestate_).get_maximum_number_of_moves());
 
         for (auto &i : sample.policy) {
             i = 0;
@@ -312,6 +833,14 @@ class MCTS {
 
             assert(best_move != -1);
             sample.policy[best_move] = 1;
+        } else if (config_.gumbel) {
+            //* improved policy is target, not visits
+            gumbel_improved_policy(gumbel_scores_);
+
+            for (int i = 0; i < root.child_count; i++) {
+                sample.policy[nodes_[root.child_index + i].move] =
+                    gumbel_scores_[i];
+            }
         } else {
             float visits_sum = 0;
 
@@ -324,7 +853,7 @@ class MCTS {
 
             if (visits_sum == 0) {
                 for (int i = 0; i < root.child_count; i++) {
-                    auto &node = nodes_[root.child_index + i];
+                    auto &&node = nodes_[root.child_index + i];
                     if (node.status != 1) {
                         node.visits = 1;
                         visits_sum += node.visits;
@@ -345,12 +874,14 @@ class MCTS {
     }
 
     void debug_stats() {
+        stop_pondering();
+
         std::cerr << "MCTS STATS\n";
         std::cerr << "Nodes cnt:" << nodes_count_ << "/" << nodes_.size()
                   << "\n";
         std::cerr << "ROOT IDX: " << root_idx_ << "\n";
 
-        auto &root = nodes_[root_idx_];
+        auto &&root = nodes_[root_idx_];
 
         for (int i = 0; i < root.child_count; i++) {
             const auto &node = nodes_[root.child_index + i];
@@ -370,13 +901,106 @@ class MCTS {
     }
 
     void debug_tree(int max_depth) {
-        debug_tree(root_idx_, root_gamestate_->clone(), max_depth);
+        stop_pondering();
+        debug_tree(root_idx_, clone_game(root_gamestate_), max_depth);
+    }
+
+    /*
+        Statistics of tree and last search without printing: pv_count
+        most visited root moves with their principal variations (up to
+        max_length moves), nodes, depth and speed. Tree is read by
+        indices, no game is cloned. Must not be called during search or
+        pondering.
+    */
+    SearchAnalysis analyze(int pv_count = 1, int max_length = 64) const {
+        assert(not is_pondering() and "stop_pondering() before analyze()");
+
+        SearchAnalysis analysis;
+        const auto &root = nodes_[root_idx_];
+
+        analysis.root_visits = root.visits;
+        analysis.allocated_nodes = nodes_count_;
+        analysis.simulations = last_simulations_;
+        analysis.search_us = last_search_us_;
+
+        if (last_search_us_ > 0) {
+            analysis.simulations_per_second =
+                (float)last_simulations_ * 1e6f / (float)last_search_us_;
+        }
+
+        //* BFS of root subtree, blocks shared by transpositions once
+        std::vector<char> seen(nodes_count_, 0);
+        std::vector<std::pair<uint32_t, int>> queue{{root_idx_, 0}};
+        seen[root_idx_] = 1;
+
+        for (size_t i = 0; i < queue.size(); i++) {
+            const auto [node_idx, depth] = queue[i];
+            const auto &node = nodes_[node_idx];
+
+            if (node.visits > 0) {
+                analysis.depth = std::max(analysis.depth, depth);
+            }
+
+            if (node.child_count < 0 or (node.child_count == 0 and
+                                         node.visits != 0 and
+                                         not node.is_solved())) {
+                analysis.pending_leaves++;
+            }
+
+            for (int j = 0; j < node.child_count; j++) {
+                const int child_idx = child_node(node.child_index, j);
+
+                if (child_idx >= 0 and not seen[child_idx]) {
+                    seen[child_idx] = 1;
+                    queue.emplace_back(child_idx, depth + 1);
+                }
+            }
+        }
+
+        analysis.nodes = queue.size();
+
+        std::vector<int> order(root.child_count);
+        for (int i = 0; i < root.child_count; i++) {
+            order[i] = i;
+        }
+
+        const int lines = std::clamp(pv_count, 0, (int)root.child_count);
+        std::partial_sort(order.begin(), order.begin() + lines, order.end(),
+                          [&](int a, int b) {
+                              return nodes_[root.child_index + a].visits >
+                                     nodes_[root.child_index + b].visits;
+                          });
+
+        for (int i = 0; i < lines; i++) {
+            std::vector<PVMove> line;
+            int node_idx = root.child_index + order[i];
+
+            while (node_idx >= 0 and (int)line.size() < max_length) {
+                const auto &node = nodes_[node_idx];
+
+                if (node.visits <= 0) {
+                    break;
+                }
+
+                line.push_back(PVMove{node.move, node.visits,
+                                      -node.get_value(), node.policy,
+                                      node.status});
+
+                node_idx = most_visited_child(node_idx);
+            }
+
+            if (not line.empty()) {
+                analysis.lines.push_back(std::move(line));
+            }
+        }
+
+        return analysis;
     }
 
     void debug_select() {
         std::cerr << "DEBUG SELECT\n";
 
-        auto &node = nodes_[root_idx_];
+        auto &&node = nodes_[root_idx_];
         const float cpuct = config_.cpuct_init;
 
         std::cerr << "cpuct:" << cpuct << "\n";
@@ -392,7 +1016,7 @@ class MCTS {
         assert(node.child_count > 0);
 
         for (int i = 0; i < node.child_count; i++) {
-            auto &child = nodes_[node.child_index + i];
+            auto &&child = nodes_[node.child_index + i];
 
             if (child.status == 1) {
                 // skip solved lose nodes
@@ -434,124 +1058,1226 @@ class MCTS {
     }
 
    private:
-    void debug_tree(int node_idx, Game state, int d) {
-        auto &root = nodes_[node_idx];
+    //* measures simulations and time of one public search call
+    struct SearchMeter {
+        BasicMCTS &mcts;
+        Stopwatch watch;
+        int root_visits;
+
+        SearchMeter(BasicMCTS &mcts_)
+            : mcts(mcts_),
+              watch(0),
+              root_visits(mcts_.nodes_[mcts_.root_idx_].visits) {}
+
+        ~SearchMeter() {
+            mcts.last_simulations_ =
+                mcts.nodes_[mcts.root_idx_].visits - root_visits;
+            mcts.last_search_us_ = watch.elapsed_microseconds();
+        }
+    };
+
+    //* -1 if node has no materialized children
+    int most_visited_child(int node_idx) const {
+        const auto &node = nodes_[node_idx];
+        int best = -1;
+
+        for (int i = 0; i < node.child_count; i++) {
+            const int child_idx = child_node(node.child_index, i);
+
+            if (child_idx >= 0 and
+                (best < 0 or nodes_[child_idx].visits > nodes_[best].visits)) {
+                best = child_idx;
+            }
+        }
+
+        return best;
+    }
+
+    //* solved children of node counted by solver and their best value
+    struct SolvedChildren {
+        int count = 0;
+        float value = -1;
+    };
+
+    //* game state following consecutive search paths
+    struct ScratchState {
+        GameState state;
+        std::vector<uint32_t> path;
+        bool valid = false;
+
+        //* incremental first layer, entry depth * 2 + player, root depth 0
+        std::vector<std::vector<int>> features;
+        std::vector<int> features_count;
+        std::vector<Accumulator> accumulators;
+        std::vector<char> accumulated;
+        const LinearLayer *feature_layer = nullptr;
+    };
+
+    void debug_tree(int node_idx, GameState state, int d) {
+        auto &&root = nodes_[node_idx];
 
         std::cerr << "Node(" << node_idx << ") val: " << root.nn_value << "\n";
         // std::cerr << root.child_index << " " << root.child_count << "\n";
-        state->debug();
+        game_ref(state).debug();
 
         if (d == 0) return;
 
         for (int i = 0; i < root.child_count; i++) {
-            const auto &node = nodes_[root.child_index + i];
+            const int child_idx = child_node(root.child_index, i);
+
+            if (child_idx < 0) {
+                continue;
+            }
 
-            auto temp = state->clone();
-            temp->make_move(node.move);
+            auto temp = clone_game(state);
+            game_ref(temp).make_move(nodes_[child_idx].move);
 
-            debug_tree(root.child_index + i, temp, d - 1);
+            debug_tree(child_idx, temp, d - 1);
         }
     }
 
-    void update(Model &model) {
-        const int node_idx = select();
-
-        if (nodes_[node_idx].is_solved()) {
-            backpropagation();
-            return;
+    /*
+        Moves scratch state from its previous path to path: unmakes moves
+        after common prefix and makes the new ones, no cloning.
+    */
+    GameType &walk_to(ScratchState &scratch,
+                      const std::vector<uint32_t> &path) {
+        if (not scratch.valid) {
+            scratch.state = clone_game(root_gamestate_);
+            scratch.valid = true;
+            scratch.path.clear();
+            reset_accumulators(scratch);
         }
 
-        Game gamestate = root_gamestate_->clone();
+        //* scratch.path doesn't contain root
+        size_t common = 0;
+        while (common < scratch.path.size() and common + 1 < path.size() and
+               scratch.path[common] == path[common + 1]) {
+            common++;
+        }
 
-        for (int i = 1; i < selected_nodes_cnt_; i++) {
-            gamestate->make_move(nodes_[selected_nodes_[i]].move);
+        while (scratch.path.size() > common) {
+            game_ref(scratch.state).unmake_move();
+            scratch.path.pop_back();
         }
 
-        expansion(node_idx, gamestate, model);
+        for (size_t i = common + 1; i < path.size(); i++) {
+            game_ref(scratch.state).push_state();
+            game_ref(scratch.state).make_move(nodes_[path[i]].move);
+            scratch.path.push_back(path[i]);
+            reset_accumulators(scratch);
+        }
 
-        backpropagation();
+        return game_ref(scratch.state);
     }
 
-    void expansion(uint32_t node_idx, Game &current_gamestate, Model &model) {
-        if (current_gamestate->is_terminal()) {
-            auto &node = nodes_[node_idx];
-            node.nn_value = current_gamestate->get_scaled_game_result();
-            node.status = current_gamestate->get_game_result();
-            node.child_count = 0;
-            node.child_index = 0;
-        } else {
-            /*
-                !calculate legal moves before forward!
-                Model will clear policy of not legal moves
-            */
-            current_gamestate->calc_legal_moves();
-            // std::cerr << "LEGAL: " << current_gamestate->legal_moves_cnt <<
-            // "\n";
+    //* accumulators at current depth of scratch path are of old position
+    void reset_accumulators(ScratchState &scratch) {
+        if (not config_.incremental_accumulator) {
+            return;
+        }
 
-            current_gamestate->get_input_for_network(
-                model.input_layer->get_output());
+        const size_t entry = scratch.path.size() * 2;
 
-            // std::cerr << *model.input_layer->output << "\n";
-            model.forward(current_gamestate);
+        if (scratch.accumulated.size() <= entry) {
+            scratch.features.resize(entry + 2);
+            scratch.features_count.resize(entry + 2);
+            scratch.accumulators.resize(entry + 2);
+            scratch.accumulated.resize(entry + 2);
+        }
 
-            // std::cerr << "MCTS OUT:" << *model.output << "\n";
+        scratch.accumulated[entry] = false;
+        scratch.accumulated[entry + 1] = false;
+    }
 
-            auto &node = nodes_[node_idx];
-            node.nn_value = model.get_value();
+    /*
+        First layer of leaf at the end of scratch path, updated from
+        accumulator of the same player nearest on the path or refreshed
+        when more features changed than leaf has. Path keeps accumulators
+        of leaves evaluated on it until search leaves their subtree.
+        nullptr if model or game can't use it.
+    */
+    const Accumulator *accumulate(ScratchState &scratch, Model &model) {
+        if (not config_.incremental_accumulator) {
+            return nullptr;
+        }
 
-            node.child_count = current_gamestate->legal_moves_cnt;
-            node.child_index = nodes_count_;
+        const LinearLayer *layer = model.get_feature_layer();
+        if (layer == nullptr) {
+            return nullptr;
+        }
 
-            const int cnt = node.child_count;
-            // std::cerr << "EXPAND\n";
-            // std::cerr << *model.output << "\n";
+        const auto &state = game_ref(scratch.state);
+        const int player = state.get_player_to_move();
+        const int leaf = (int)scratch.path.size() * 2 + player;
+        auto &features = scratch.features[leaf];
 
-            for (int i = 0; i < cnt; i++) {
-                const int move_idx = current_gamestate->legal_moves[i];
+        features.resize(layer->weights.size());
+        const int cnt = state.get_active_features(player, features.data());
+        scratch.features_count[leaf] = cnt;
 
-                if (nodes_count_ == nodes_.size()) {
-                    // std::cerr << "[CPP] Increase reserved nodes in MCTS!\n";
-                    nodes_.emplace_back(move_idx, model.get_policy(move_idx));
-                } else {
-                    nodes_[nodes_count_] =
-                        MCTSNode(move_idx, model.get_policy(move_idx));
-                }
+        if (cnt < 0) {
+            return nullptr;
+        }
 
-                // std::cerr << nodes_[nodes_count_].policy << "\n";
+        //* accumulators of other weights are useless
+        if (scratch.feature_layer != layer) {
+            std::fill(scratch.accumulated.begin(), scratch.accumulated.end(),
+                      false);
+            scratch.feature_layer = layer;
+        }
 
-                nodes_count_++;
-            }
+        int from = leaf - 2;
+        while (from >= 0 and not scratch.accumulated[from]) {
+            from -= 2;
         }
 
-        if (node_idx == root_idx_) {
-            add_dirichlet_noise(node_idx, config_.dirichlet_noise_epsilon,
-                                config_.dirichlet_noise_alpha);
+        auto &accumulator = scratch.accumulators[leaf];
+
+        if (from >= 0 and
+            Accumulator::changed_features(scratch.features[from].data(),
+                                          scratch.features_count[from],
+                                          features.data(), cnt) < cnt) {
+            accumulator.update(scratch.accumulators[from], *layer,
+                               scratch.features[from].data(),
+                               scratch.features_count[from], features.data(),
+                               cnt);
+        } else {
+            accumulator.refresh(*layer, features.data(), cnt);
         }
+
+        scratch.accumulated[leaf] = true;
+        return &accumulator;
     }
 
-    void add_dirichlet_noise(uint32_t node_idx, float epsilon, float alpha) {
-        if (epsilon < 0.001f) {
-            return;
-        }
+    void update(Model &model) {
+        keep_node_budget(max_moves());
 
-        if (alpha < 0.001f) {
+        const int node_idx = select(selected_nodes_);
+
+        if (nodes_[node_idx].is_solved()) {
+            backpropagation(selected_nodes_, true);
             return;
         }
 
-        auto &node = nodes_[node_idx];
+        GameType &gamestate = walk_to(scratch_, selected_nodes_);
 
-        if (node.child_count == 0) {
-            return;
+        if (use_transpositions(node_idx)) {
+            const uint64_t key =
+                position_key(gamestate, selected_nodes_.size() - 1);
+
+            if (not share_transposition(node_idx, key)) {
+                expansion(node_idx, gamestate, model, &scratch_);
+                store_transposition(node_idx, key);
+            }
+        } else {
+            expansion(node_idx, gamestate, model, &scratch_);
         }
 
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::vector<float> dirichlet_vector(node.child_count);
-        std::gamma_distribution<float> gamma(alpha, 1.0f);
+        backpropagation(selected_nodes_);
+    }
+
+    /*
+        Selects up to max_leaves leaves, evaluates them with one
+        Model::forward_batch and backpropagates all of them.
+        Virtual loss on selected paths makes next selections in the same
+        batch go to different leaves. Returns number of simulations done.
+    */
+    int update_batch(Model &model, int max_leaves) {
+        keep_node_budget((size_t)max_leaves * max_moves());
+
+        int simulations = 0;
+        int leaves = 0;
+
+        while (simulations < max_leaves) {
+            if (batch_paths_.size() == leaves) {
+                batch_paths_.emplace_back();
+                batch_legal_moves_.emplace_back();
+            }
+
+            auto &path = batch_paths_[leaves];
+            const int node_idx = select(path);
+
+            if (nodes_[node_idx].child_count < 0) {
+                //* leaf is already waiting for evaluation in this batch
+                break;
+            }
+
+            if (nodes_[node_idx].is_solved()) {
+                backpropagation(path, true);
+                simulations++;
+                continue;
+            }
+
+            GameType &gamestate = walk_to(scratch_, path);
+
+            simulations++;
+
+            if (gamestate.is_terminal()) {
+                expansion(node_idx, gamestate, model);
+                backpropagation(path);
+                continue;
+            }
+
+            if (batch_keys_.size() == leaves) {
+                batch_keys_.emplace_back();
+            }
+
+            if (use_transpositions(node_idx)) {
+                batch_keys_[leaves] = position_key(gamestate, path.size() - 1);
+
+                if (share_transposition(node_idx, batch_keys_[leaves])) {
+                    backpropagation(path);
+                    continue;
+                }
+            }
+
+            gamestate.calc_legal_moves();
+            gamestate.get_input_for_network(model.get_batch_input(leaves));
+
+            auto &legal_moves = batch_legal_moves_[leaves];
+            legal_moves.assign(
+                gamestate.legal_moves.begin(),
+                gamestate.legal_moves.begin() + gamestate.legal_moves_cnt);
+
+            //* mark leaf as pending, select() stops on it
+            nodes_[node_idx].child_count = -1;
+            add_virtual_loss(path, 1);
+            leaves++;
+        }
+
+        if (leaves == 0) {
+            return simulations;
+        }
+
+        model.forward_batch(leaves, batch_legal_moves_);
+
+        for (int i = 0; i < leaves; i++) {
+            const auto &path = batch_paths_[i];
+            const uint32_t node_idx = path.back();
+            const auto &legal_moves = batch_legal_moves_[i];
+
+            nodes_[node_idx].nn_value = model.get_value(i);
+            add_children(node_idx, legal_moves.data(), legal_moves.size(),
+                         [&](int move) { return model.get_policy(i, move); });
+
+            if (use_transpositions(node_idx)) {
+                store_transposition(node_idx, batch_keys_[i]);
+            }
+
+            add_virtual_loss(path, -1);
+            backpropagation(path);
+        }
+
+        return simulations;
+    }
+
+    //* compact() step for lazy block of compact_buffer_[node], copied once
+    void compact_lazy_block(size_t node) {
+        constexpr uint32_t REMOVED = UINT32_MAX;
+
+        const int old_edge = -compact_buffer_[node].child_index - 1;
+        const int child_count = compact_buffer_[node].child_count;
+
+        //* block was already copied by transposition
+        if (edge_remap_[old_edge] != REMOVED) {
+            compact_buffer_[node].child_index = -(int)edge_remap_[old_edge] - 1;
+            return;
+        }
+
+        edge_remap_[old_edge] = compact_edges_.size();
+        compact_buffer_[node].child_index = -(int)compact_edges_.size() - 1;
+
+        for (int j = 0; j < child_count; j++) {
+            MCTSEdge edge = edges_[old_edge + j];
+
+            if (edge.node >= 0) {
+                node_remap_[edge.node] = compact_buffer_.size();
+                compact_buffer_.push_back(nodes_[edge.node]);
+                edge.node = node_remap_[edge.node];
+            }
+
+            compact_edges_.push_back(edge);
+        }
+    }
+
+    /*
+        Gumbel root search (Danihelka et al., "Policy improvement by
+        planning with Gumbel"). Top gumbel_actions root moves by
+        gumbel + log(prior) are searched with sequential halving, every
+        phase splits budget equally between remaining moves and keeps
+        the better half by gumbel + log(prior) + sigma(q).
+        Nodes below root still use PUCT.
+    */
+    void gumbel_search(Model &model, int iterations) {
+        if (nodes_[root_idx_].child_count == 0) {
+            update(model);
+            iterations--;
+        }
+
+        const int count = nodes_[root_idx_].child_count;
+        int first = nodes_[root_idx_].child_index;
+
+        if (count == 0 or nodes_[root_idx_].is_solved()) {
+            return;
+        }
+
+        gumbel_noise_.resize(count);
+        gumbel_scores_.resize(count);
+        gumbel_candidates_.resize(count);
+
+        for (int i = 0; i < count; i++) {
+            const float u = std::clamp(Random::instance().next_float(),
+                                       1e-7f, 1.0f - 1e-7f);
+            gumbel_noise_[i] = -std::log(-std::log(u)) +
+                               std::log(std::max(
+                                   (float)nodes_[first + i].policy, 1e-12f));
+            gumbel_candidates_[i] = i;
+        }
+
+        auto by_noise = [&](int a, int b) {
+            return gumbel_noise_[a] > gumbel_noise_[b];
+        };
+
+        const int actions = std::max(1, std::min(config_.gumbel_actions, count));
+        std::partial_sort(gumbel_candidates_.begin(),
+                          gumbel_candidates_.begin() + actions,
+                          gumbel_candidates_.end(), by_noise);
+        gumbel_candidates_.resize(actions);
+
+        const int phases = std::max(1, (int)std::ceil(std::log2(actions)));
+
+        for (int phase = 0;
+             phase < phases and not nodes_[root_idx_].is_solved(); phase++) {
+            const int visits = std::max(
+                1, iterations / (phases * (int)gumbel_candidates_.size()));
+
+            for (const int child : gumbel_candidates_) {
+                forced_root_child_ = child;
+
+                for (int i = 0;
+                     i < visits and not nodes_[root_idx_].is_solved();) {
+                    if (config_.batch_size > 1) {
+                        i += update_batch(
+                            model, std::min(config_.batch_size, visits - i));
+                    } else {
+                        update(model);
+                        i++;
+                    }
+                }
+            }
+
+            forced_root_child_ = -1;
+
+            //* keeping node budget can compact tree and move root children
+            first = nodes_[root_idx_].child_index;
+
+            //* keep better half
+            const int max_visits = gumbel_max_visits();
+            for (const int child : gumbel_candidates_) {
+                gumbel_scores_[child] =
+                    gumbel_noise_[child] +
+                    gumbel_sigma(gumbel_q(nodes_[first + child]), max_visits);
+            }
+
+            std::sort(gumbel_candidates_.begin(), gumbel_candidates_.end(),
+                      [&](int a, int b) {
+                          return gumbel_scores_[a] > gumbel_scores_[b];
+                      });
+            gumbel_candidates_.resize((gumbel_candidates_.size() + 1) / 2);
+        }
+
+        forced_root_child_ = -1;
+        gumbel_move_ = nodes_[first + gumbel_candidates_[0]].move;
+    }
+
+    //* value of root child for player to move in root
+    template <class Node>
+    static float gumbel_q(const Node &child) {
+        return -child.get_value();
+    }
+
+    int gumbel_max_visits() const {
+        const auto &root = nodes_[root_idx_];
+
+        int max_visits = 0;
+        for (int i = 0; i < root.child_count; i++) {
+            max_visits = std::max(max_visits,
+                                  (int)nodes_[root.child_index + i].visits);
+        }
+
+        return max_visits;
+    }
+
+    //* monotone transformation of q from [-1, 1], grows with visits
+    float gumbel_sigma(float q, int max_visits) const {
+        return (config_.gumbel_c_visit + max_visits) * config_.gumbel_c_scale *
+               (q + 1) * 0.5f;
+    }
+
+    /*
+        pi = softmax(log(prior) + sigma(completed q)) of root children,
+        unvisited children get mixed value of root network value and q
+        of visited ones weighted by prior.
+    */
+    void gumbel_improved_policy(std::vector<float> &pi) const {
+        const auto &root = nodes_[root_idx_];
+        pi.resize(root.child_count);
+
+        float visits_sum = 0;
+        float policy_sum = 0;
+        float weighted_q = 0;
+
+        for (int i = 0; i < root.child_count; i++) {
+            const auto &child = nodes_[root.child_index + i];
+
+            if (child.visits > 0) {
+                visits_sum += child.visits;
+                policy_sum += child.policy;
+                weighted_q += child.policy * gumbel_q(child);
+            }
+        }
+
+        float mixed_value = root.nn_value;
+        if (visits_sum > 0 and policy_sum > 0) {
+            mixed_value =
+                (root.nn_value + visits_sum / policy_sum * weighted_q) /
+                (1 + visits_sum);
+        }
+
+        const int max_visits = gumbel_max_visits();
+        float max_logit = -std::numeric_limits<float>::max();
+
+        for (int i = 0; i < root.child_count; i++) {
+            const auto &child = nodes_[root.child_index + i];
+            const float q = child.visits > 0 ? gumbel_q(child) : mixed_value;
+
+            pi[i] = std::log(std::max((float)child.policy, 1e-12f)) +
+                    gumbel_sigma(q, max_visits);
+            max_logit = std::max(max_logit, pi[i]);
+        }
+
+        float sum = 0;
+        for (auto &p : pi) {
+            p = std::exp(p - max_logit);
+            sum += p;
+        }
+
+        for (auto &p : pi) {
+            p /= sum;
+        }
+    }
+
+    int most_visited_root_child() const {
+        const auto &root = nodes_[root_idx_];
+
+        int best = 0;
+        for (int i = 1; i < root.child_count; i++) {
+            if (nodes_[root.child_index + i].visits >
+                nodes_[root.child_index + best].visits) {
+                best = i;
+            }
+        }
+
+        return best;
+    }
+
+    //* difference of values of two most visited root children
+    float root_q_gap() const {
+        const auto &root = nodes_[root_idx_];
+
+        int best = -1;
+        int second = -1;
+
+        for (int i = 0; i < root.child_count; i++) {
+            const int visits = nodes_[root.child_index + i].visits;
+
+            if (best == -1 or visits > nodes_[root.child_index + best].visits) {
+                second = best;
+                best = i;
+            } else if (second == -1 or
+                       visits > nodes_[root.child_index + second].visits) {
+                second = i;
+            }
+        }
+
+        if (second == -1) {
+            return 2;
+        }
+
+        return std::abs(nodes_[root.child_index + second].get_value() -
+                        nodes_[root.child_index + best].get_value());
+    }
+
+    /*
+        Smart stop, true when the second most visited root child can't
+        catch up with the best one in remaining simulations.
+        config_.smart_stop scales remaining, below 1 it stops earlier.
+    */
+    bool best_move_decided(float remaining) const {
+        const auto &root = nodes_[root_idx_];
+
+        int best = 0;
+        int second = 0;
+
+        for (int i = 0; i < root.child_count; i++) {
+            const int visits = nodes_[root.child_index + i].visits;
+
+            if (visits > best) {
+                second = best;
+                best = visits;
+            } else if (visits > second) {
+                second = visits;
+            }
+        }
+
+        return best - second > remaining * config_.smart_stop;
+    }
+
+    bool can_stop_early(float remaining) {
+        if (config_.smart_stop <= 0 or not best_move_decided(remaining)) {
+            return false;
+        }
+
+        saved_simulations_ = remaining;
+        return true;
+    }
+
+    //* simulations that fit in rest of ms at speed of the first done
+    static float remaining_simulations(Stopwatch &watch, int ms, int done) {
+        const long long elapsed = watch.elapsed_milliseconds();
+
+        if (elapsed <= 0) {
+            return std::numeric_limits<float>::max();
+        }
+
+        return (float)done * (float)(ms - elapsed) / (float)elapsed;
+    }
+
+    inline size_t max_moves() const {
+        return game_ref(root_gamestate_).get_maximum_number_of_moves();
+    }
+
+    //* max_nodes with room for a few expansions of batch_size leaves
+    size_t node_budget() const {
+        const size_t expansion = max_moves() * std::max(1, config_.batch_size);
+
+        return std::max((size_t)config_.max_nodes, 4 * expansion);
+    }
+
+    /*
+        Called before selecting leaves. When needed more nodes don't fit in
+        max_nodes, drops nodes outside root subtree and if it isn't enough
+        prunes least visited subtrees until tree takes half of budget.
+    */
+    void keep_node_budget(size_t needed) {
+        if (config_.max_nodes <= 0) {
+            return;
+        }
+
+        const size_t budget = node_budget();
+
+        auto fits = [&]() {
+            return nodes_count_ + needed <= budget and
+                   edges_count_ + needed <= budget;
+        };
+
+        if (fits()) {
+            return;
+        }
+
+        compact();
+
+        if (fits()) {
+            return;
+        }
+
+        compact(pruning_visits(budget / 2));
+    }
+
+    /*
+        Smallest visits count of expanded nodes that are kept, so that
+        their children take at most target nodes. Tree must be compacted,
+        every node is then in root subtree. Solved nodes are always kept,
+        they can become root and need children for get_best.
+    */
+    int pruning_visits(size_t target) {
+        prune_candidates_.clear();
+        size_t kept = 1 + nodes_[root_idx_].child_count;
+
+        for (size_t i = 0; i < nodes_count_; i++) {
+            const auto &node = nodes_[i];
+
+            if (i == root_idx_ or node.child_count <= 0) {
+                continue;
+            }
+
+            if (node.is_solved()) {
+                kept += node.child_count;
+            } else {
+                prune_candidates_.emplace_back(node.visits, node.child_count);
+            }
+        }
+
+        std::sort(prune_candidates_.begin(), prune_candidates_.end(),
+                  std::greater<std::pair<int, int>>());
+
+        for (const auto &[visits, child_count] : prune_candidates_) {
+            kept += child_count;
+
+            if (kept > target) {
+                return visits + 1;
+            }
+        }
+
+        return 0;
+    }
+
+    //* compact() step, node of compact_buffer_ loses its children
+    static void prune_children(MCTSNode &node) {
+        node.child_index = 0;
+        node.child_count = 0;
+        node.children_draw = 0;
+    }
+
+    //* root moves to its child with kept_visits, rest of its subtree is lost
+    void abandon_root(int kept_visits) {
+        abandoned_visits_ +=
+            std::max(0, (int)nodes_[root_idx_].visits - kept_visits);
+    }
+
+    /*
+        Compacts when nodes abandoned by root moves since last compaction
+        are more than compact_threshold of nodes_count_. Subtree grows
+        with its visits, so abandoned part is estimated from visits of old
+        roots that weren't kept, no tree walk.
+    */
+    void maybe_compact() {
+        if (config_.compact_threshold > 1.0f) {
+            return;
+        }
+
+        const float kept_visits = nodes_[root_idx_].visits;
+
+        if (abandoned_visits_ >= config_.compact_threshold *
+                                     (abandoned_visits_ + kept_visits)) {
+            compact();
+        }
+    }
+
+    //* iterations = -1 for timed search, time can stop it before ms
+    void search_concurrent(std::vector<Model> &models, int iterations,
+                           int ms, TimeManager *time = nullptr) {
+        saved_simulations_ = 0;
+        gumbel_move_ = -1;
+
+        if (nodes_[root_idx_].is_solved()) {
+            return;
+        }
+
+        Stopwatch watch(std::max(ms, 0));
+
+        if (nodes_[root_idx_].child_count == 0) {
+            //* root expansion adds dirichlet noise, do it before threads
+            update(models[0]);
+            iterations--;
+        }
+
+        //* threads can only stop when nodes run out, give them half
+        if (config_.max_nodes > 0) {
+            keep_node_budget(node_budget() / 2);
+        }
+
+        //* threads can't reallocate nodes, reserve them upfront
+        nodes_.resize(concurrent_reserve(nodes_.size(), nodes_count_,
+                                         iterations));
+
+        if (config_.lazy_children) {
+            edges_.resize(concurrent_reserve(edges_.size(), edges_count_,
+                                             iterations));
+        }
+
+        std::atomic<int> simulations{0};
+        std::atomic<bool> stopped{false};
+        out_of_nodes_ = false;
+
+        auto work = [&](Model &model) {
+            std::vector<uint32_t> path;
+            ScratchState scratch;
+
+            while (not out_of_nodes_ and not nodes_[root_idx_].is_solved() and
+                   not stopped) {
+                if (iterations >= 0) {
+                    const int done = simulations.fetch_add(1);
+
+                    if (done >= iterations) {
+                        break;
+                    }
+
+                    if (config_.smart_stop > 0 and
+                        best_move_decided(iterations - done) and
+                        not stopped.exchange(true)) {
+                        saved_simulations_ = iterations - done;
+                        break;
+                    }
+                } else if (watch.timeout()) {
+                    break;
+                } else if (config_.smart_stop > 0) {
+                    const float remaining =
+                        remaining_simulations(watch, ms, simulations++);
+
+                    if (best_move_decided(remaining) and
+                        not stopped.exchange(true)) {
+                        saved_simulations_ = remaining;
+                        break;
+                    }
+                }
+
+                while (not update_concurrent(model, path, scratch)) {
+                    if (out_of_nodes_) {
+                        break;
+                    }
+
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (auto &model : models) {
+            threads.emplace_back(work, std::ref(model));
+        }
+
+        if (time != nullptr) {
+            const int check_every = std::max(1, time->optimal_time() / 10);
+            int best_child = most_visited_root_child();
+
+            while (not stopped and not out_of_nodes_ and
+                   not nodes_[root_idx_].is_solved() and not watch.timeout()) {
+                const long long elapsed = watch.elapsed_milliseconds();
+                std::this_thread::sleep_for(std::chrono::milliseconds(
+                    std::clamp<long long>(ms - elapsed, 1, check_every)));
+
+                const int current = most_visited_root_child();
+                const bool changed = current != best_child;
+                best_child = current;
+
+                if (time->can_stop(watch.elapsed_milliseconds(), changed,
+                                   root_q_gap())) {
+                    stopped = true;
+                }
+            }
+        }
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        //* failed allocations could move it past the end
+        nodes_count_ = std::min(nodes_count_, nodes_.size());
+        edges_count_ = std::min(edges_count_, edges_.size());
+    }
+
+    /*
+        Size of nodes or edges array for tree-parallel search, count of
+        them used. Every iteration adds at most max_moves(). Timed search
+        has no known number of iterations, without max_nodes it gets at
+        least ponder_max_nodes free, like pondering.
+    */
+    size_t concurrent_reserve(size_t size, size_t count,
+                              int iterations) const {
+        size_t reserved = std::max(size, (size_t)config_.init_reserved_nodes);
+
+        if (iterations > 0) {
+            reserved =
+                std::max(reserved, count + (size_t)iterations * max_moves());
+        } else if (iterations < 0) {
+            reserved = std::max(reserved, count + ponder_max_nodes);
+        }
+
+        if (config_.max_nodes > 0) {
+            reserved = std::min(reserved, node_budget());
+        }
+
+        return reserved;
+    }
+
+    //* returns false if leaf is expanded by another thread
+    bool update_concurrent(Model &model, std::vector<uint32_t> &path,
+                           ScratchState &scratch) {
+        const int node_idx = select<true>(path);
+        add_virtual_loss<true>(path, 1);
+
+        auto &&node = nodes_[node_idx];
+
+        if (node.is_solved()) {
+            add_virtual_loss<true>(path, -1);
+            backpropagation<true>(path, true);
+            return true;
+        }
+
+        //* claim the leaf, other threads will see it as pending
+        if (not claim_child_count(node.child_count, 0, -1)) {
+            add_virtual_loss<true>(path, -1);
+            return false;
+        }
+
+        GameType &gamestate = walk_to(scratch, path);
+
+        if (gamestate.is_terminal()) {
+            node.nn_value = gamestate.get_scaled_game_result();
+            node.status = gamestate.get_game_result();
+            node.child_index = 0;
+            store_child_count(node.child_count, 0);
+        } else if (use_transpositions(node_idx) and
+                   share_transposition<true>(
+                       node_idx, position_key(gamestate, path.size() - 1))) {
+            //* children of equal position are already in tree
+        } else {
+            gamestate.calc_legal_moves();
+            model.set_input(gamestate);
+            model.forward(gamestate);
+
+            const int cnt = gamestate.legal_moves_cnt;
+            const bool lazy = config_.lazy_children;
+            const size_t first = __atomic_fetch_add(
+                lazy ? &edges_count_ : &nodes_count_, cnt, __ATOMIC_RELAXED);
+
+            if (first + cnt > (lazy ? edges_.size() : nodes_.size())) {
+                out_of_nodes_ = true;
+                store_child_count(node.child_count, 0);
+                add_virtual_loss<true>(path, -1);
+                return false;
+            }
+
+            for (int i = 0; i < cnt; i++) {
+                const int move_idx = gamestate.legal_moves[i];
+
+                if (lazy) {
+                    edges_[first + i] =
+                        MCTSEdge{move_idx, model.get_policy(move_idx), -1};
+                } else {
+                    nodes_[first + i] =
+                        MCTSNode(move_idx, model.get_policy(move_idx));
+                }
+            }
+
+            node.nn_value = model.get_value();
+            node.child_index = lazy ? -(int)first - 1 : (int)first;
+            store_child_count(node.child_count, cnt);
+
+            if (use_transpositions(node_idx)) {
+                store_transposition(node_idx,
+                                    position_key(gamestate, path.size() - 1));
+            }
+        }
+
+        add_virtual_loss<true>(path, -1);
+        backpropagation<true>(path);
+        return true;
+    }
+
+    //* root is skipped, its children get dirichlet noise
+    inline bool use_transpositions(uint32_t node_idx) const {
+        return transpositions_.enabled() and node_idx != root_idx_;
+    }
+
+    //* depth is distance from root, ply keeps graph acyclic
+    uint64_t position_key(const GameType &gamestate, int depth) const {
+        const uint64_t ply = root_ply_ + depth;
+        return gamestate.calc_hash() ^ (ply * 0x9E3779B97F4A7C15ULL);
+    }
+
+    /*
+        Leaf gets children block and nn value of already expanded node
+        with the same key. Both nodes keep their own visits and scores,
+        statistics of children are shared.
+    */
+    template <bool concurrent = false>
+    bool share_transposition(uint32_t node_idx, uint64_t key) {
+        const int64_t other_idx = transpositions_.find(key);
+
+        if (other_idx < 0 or other_idx == node_idx) {
+            return false;
+        }
+
+        const auto &other = nodes_[other_idx];
+        int child_count = other.child_count;
+        if constexpr (concurrent) {
+            child_count = load_child_count(other.child_count);
+        }
+
+        if (child_count <= 0) {
+            return false;
+        }
+
+        auto &&node = nodes_[node_idx];
+        node.nn_value = other.nn_value;
+        node.child_index = other.child_index;
+        node.children_draw = other.children_draw;
+
+        if constexpr (concurrent) {
+            store_child_count(node.child_count, child_count);
+        } else {
+            node.child_count = child_count;
+        }
+
+        return true;
+    }
+
+    inline void store_transposition(uint32_t node_idx, uint64_t key) {
+        if (nodes_[node_idx].child_count > 0) {
+            transpositions_.store(key, node_idx);
+        }
+    }
+
+    //* visits = 1 adds virtual loss, visits = -1 removes it
+    template <bool concurrent = false>
+    void add_virtual_loss(const std::vector<uint32_t> &path, int visits) {
+        const float loss = visits * config_.virtual_loss;
+
+        //* every node on path looks like a loss for its parent
+        for (const auto node_idx : path) {
+            auto &&node = nodes_[node_idx];
+            add_to<concurrent>(node.visits, visits);
+            add_to<concurrent>(node.score_sum, loss);
+        }
+    }
+
+    /*
+        Lazy block keeps children as edges until they are selected,
+        child_index = -(index of first edge + 1).
+        Returns node of i-th child, -1 if edge has no node yet.
+    */
+    template <bool concurrent = false>
+    inline int child_node(int child_index, int i) const {
+        if (child_index >= 0) {
+            return child_index + i;
+        }
+
+        const auto &edge = edges_[-child_index - 1 + i];
+
+        if constexpr (concurrent) {
+            return __atomic_load_n(&edge.node, __ATOMIC_ACQUIRE);
+        }
+
+        return edge.node;
+    }
+
+    //* allocates node of edge if needed, -1 if reserved nodes run out
+    template <bool concurrent = false>
+    int edge_node(int edge_idx) {
+        auto &edge = edges_[edge_idx];
+
+        if constexpr (concurrent) {
+            int node = __atomic_load_n(&edge.node, __ATOMIC_ACQUIRE);
+            if (node >= 0) {
+                return node;
+            }
+
+            const size_t idx =
+                __atomic_fetch_add(&nodes_count_, 1, __ATOMIC_RELAXED);
+
+            if (idx >= nodes_.size()) {
+                out_of_nodes_ = true;
+                return -1;
+            }
+
+            nodes_[idx] = MCTSNode(edge.move, edge.policy);
+
+            //* if another thread was first, idx is wasted
+            if (__atomic_compare_exchange_n(&edge.node, &node, (int)idx, false,
+                                            __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE)) {
+                return idx;
+            }
+
+            return node;
+        }
+
+        if (edge.node < 0) {
+            edge.node = push_node(MCTSNode(edge.move, edge.policy));
+        }
+
+        return edge.node;
+    }
+
+    //* appends node after nodes_count_, returns its index
+    uint32_t push_node(const MCTSNode &node) {
+        if (nodes_count_ == nodes_.size()) {
+            nodes_.emplace_back(node.move, node.policy);
+        }
+
+        nodes_[nodes_count_] = node;
+        return nodes_count_++;
+    }
+
+    /*
+        Replaces lazy block of node with contiguous block of nodes,
+        used for new root, so code reading root children needs no edges.
+    */
+    void materialize_children(uint32_t node_idx) {
+        const int child_index = nodes_[node_idx].child_index;
+
+        if (child_index >= 0) {
+            return;
+        }
+
+        const int first = nodes_count_;
+
+        const int first_edge = -child_index - 1;
+        const int count = nodes_[node_idx].child_count;
+
+        for (int i = 0; i < count; i++) {
+            auto &&edge = edges_[first_edge + i];
+
+            //* copy, push_node can move nodes_
+            const MCTSNode child = edge.node >= 0
+                                       ? MCTSNode(nodes_[edge.node])
+                                       : MCTSNode(edge.move, edge.policy);
+            const uint32_t child_idx = push_node(child);
+
+            if (edge.node >= 0 and
+                (size_t)edge.node < solved_children_.size()) {
+                const SolvedChildren counters = solved_children_[edge.node];
+                solved_children(child_idx) = counters;
+            }
+        }
+
+        //* transpositions of old children have to see the moved ones
+        if (transpositions_.enabled()) {
+            transpositions_.remap([&](uint32_t idx) -> int64_t {
+                for (int i = 0; i < count; i++) {
+                    if (edges_[first_edge + i].node == (int)idx) {
+                        return first + i;
+                    }
+                }
+                return idx;
+            });
+        }
+
+        //* edge block can be shared with other nodes by transposition
+        for (int i = 0; i < count; i++) {
+            edges_[first_edge + i].node = first + i;
+        }
+
+        nodes_[node_idx].child_index = first;
+    }
+
+    template <class Policy>
+    void add_children(uint32_t node_idx, const int *moves, int cnt,
+                      const Policy &policy) {
+        auto &&node = nodes_[node_idx];
+        node.child_count = cnt;
+
+        //* root children are always nodes, they get dirichlet noise
+        if (config_.lazy_children and node_idx != root_idx_) {
+            node.child_index = -(int)edges_count_ - 1;
+
+            for (int i = 0; i < cnt; i++) {
+                const MCTSEdge edge{moves[i], policy(moves[i]), -1};
+
+                if (edges_count_ == edges_.size()) {
+                    edges_.push_back(edge);
+                } else {
+                    edges_[edges_count_] = edge;
+                }
+
+                edges_count_++;
+            }
+
+            return;
+        }
+
+        node.child_index = nodes_count_;
+
+        for (int i = 0; i < cnt; i++) {
+            const int move_idx = moves[i];
+
+            if (nodes_count_ == nodes_.size()) {
+                // std::cerr << "[CPP] Increase reserved nodes in MCTS!\n";
+                nodes_.emplace_back(move_idx, policy(move_idx));
+            } else {
+                nodes_[nodes_count_] = MCTSNode(move_idx, policy(move_idx));
+            }
+
+            // std::cerr << nodes_[nodes_count_].policy << "\n";
+
+            nodes_count_++;
+        }
+
+        //* Gumbel search explores root with its own noise
+        if (node_idx == root_idx_ and not config_.gumbel) {
+            add_dirichlet_noise(node_idx, config_.dirichlet_noise_epsilon,
+                                config_.dirichlet_noise_alpha);
+        }
+    }
+
+    //* scratch is given when current_gamestate is its leaf
+    void expansion(uint32_t node_idx, GameType &current_gamestate,
+                   Model &model, ScratchState *scratch = nullptr) {
+        if (current_gamestate.is_terminal()) {
+            auto &&node = nodes_[node_idx];
+            node.nn_value = current_gamestate.get_scaled_game_result();
+            node.status = current_gamestate.get_game_result();
+            node.child_count = 0;
+            node.child_index = 0;
+        } else {
+            /*
+                !calculate legal moves before forward!
+                Model will clear policy of not legal moves
+            */
+            current_gamestate.calc_legal_moves();
+            // std::cerr << "LEGAL: " << current_gamestate.legal_moves_cnt <<
+            // "\n";
+
+            const Accumulator *accumulator =
+                scratch ? accumulate(*scratch, model) : nullptr;
+
+            if (accumulator) {
+                model.forward(*accumulator, current_gamestate);
+            } else {
+                model.set_input(current_gamestate);
+
+                // std::cerr << *model.input_layer->output << "\n";
+                model.forward(current_gamestate);
+            }
+
+            // std::cerr << "MCTS OUT:" << *model.output << "\n";
+
+            nodes_[node_idx].nn_value = model.get_value();
+
+            // std::cerr << "EXPAND\n";
+            // std::cerr << *model.output << "\n";
+
+            add_children(node_idx, current_gamestate.legal_moves.data(),
+                         current_gamestate.legal_moves_cnt,
+                         [&](int move) { return model.get_policy(move); });
+        }
+    }
+
+    void add_dirichlet_noise(uint32_t node_idx, float epsilon, float alpha) {
+        if (epsilon < 0.001f) {
+            return;
+        }
+
+        if (alpha < 0.001f) {
+            return;
+        }
+
+        auto &&node = nodes_[node_idx];
+
+        if (node.child_count == 0) {
+            return;
+        }
+
+        //* stream of calling thread, workers don't share generator
+        dirichlet_noise_.resize(node.child_count);
+        Random::instance().fill_gamma(alpha, dirichlet_noise_.data(),
+                                      node.child_count);
 
         float factor_dirich = 0;
-        for (auto &i : dirichlet_vector) {
-            i = gamma(gen);
+        for (const float i : dirichlet_noise_) {
             factor_dirich += i;
         }
 
@@ -562,22 +2288,31 @@ class MCTS {
         factor_dirich = epsilon / factor_dirich;
 
         for (int i = 0; i < node.child_count; i++) {
-            auto &child = nodes_[node.child_index + i];
+            auto &&child = nodes_[node.child_index + i];
 
             // std::cerr << "before " << child.policy << " ";
             child.policy = child.policy * (1.f - epsilon) +
-                           dirichlet_vector[i] * factor_dirich;
+                           dirichlet_noise_[i] * factor_dirich;
             // std::cerr << "after " << child.policy << "\n";
         }
     }
 
+    template <bool concurrent = false>
     float max_solved_child_nn_value(int node_idx) {
         const auto &node = nodes_[node_idx];
 
         float value = -1;
 
         for (int i = 0; i < node.child_count; i++) {
-            const auto &child = nodes_[node.child_index + i];
+            const int child_idx =
+                child_node<concurrent>(node.child_index, i);
+
+            //* child of lazy block without node isn't solved
+            if (child_idx < 0) {
+                continue;
+            }
+
+            const auto &child = nodes_[child_idx];
 
             if (not child.is_solved()) {
                 continue;
@@ -589,16 +2324,60 @@ class MCTS {
         return value;
     }
 
-    void backpropagation() {
-        const int node_idx = selected_nodes_[selected_nodes_cnt_ - 1];
+    //* counters of node, array grows with nodes_ when solver needs them
+    SolvedChildren &solved_children(uint32_t node_idx) {
+        if (solved_children_.size() <= node_idx) {
+            solved_children_.resize(nodes_.size());
+        }
+
+        return solved_children_[node_idx];
+    }
+
+    /*
+        Counts solved children of node from scratch, needed only with
+        transpositions: shared children can be solved through the other
+        parent, which is the only one counting them.
+    */
+    template <bool concurrent = false>
+    void recount_solved_children(int node_idx) {
+        auto &&node = nodes_[node_idx];
+        auto &solved = solved_children(node_idx);
+
+        solved = SolvedChildren();
+
+        for (int i = 0; i < node.child_count; i++) {
+            const int child_idx = child_node<concurrent>(node.child_index, i);
+
+            if (child_idx < 0 or not nodes_[child_idx].is_solved()) {
+                continue;
+            }
+
+            const auto &child = nodes_[child_idx];
+            solved.count++;
+            solved.value = std::max(solved.value, -(float)child.nn_value);
+
+            if (child.status == 0) {
+                node.children_draw = 1;
+            }
+        }
+    }
+
+    /*
+        solved_before - leaf was solved when select() returned it, so its
+        parent already counted it. Otherwise it was solved by expansion.
+    */
+    template <bool concurrent = false>
+    void backpropagation(const std::vector<uint32_t> &path,
+                         bool solved_before = false) {
+        const int node_idx = path.back();
 
         if (not nodes_[node_idx].is_solved()) {
             float score = nodes_[node_idx].nn_value;
 
-            for (int i = selected_nodes_cnt_ - 1; i >= 0; i--) {
-                auto &node = nodes_[selected_nodes_[i]];
-                node.visits += 1;
-                node.score_sum += score;
+            for (int i = (int)path.size() - 1; i >= 0; i--) {
+                auto &&node = nodes_[path[i]];
+                add_to<concurrent>(node.visits, 1);
+                add_to<concurrent>(node.score_sum, score);
 
                 score = -score;
             }
@@ -606,89 +2385,132 @@ class MCTS {
             return;
         }
 
+        //* solver updates are rare, threads do them one at a time
+        std::unique_lock<std::mutex> lock(solver_mutex_, std::defer_lock);
+        if constexpr (concurrent) {
+            lock.lock();
+        }
+
         //* node is solved
-        auto &solved_node = nodes_[node_idx];
-        solved_node.visits++;
+        auto &&solved_node = nodes_[node_idx];
+        add_to<concurrent>(solved_node.visits, 1);
         float score = -solved_node.nn_value;
         int status = -solved_node.status;
+        bool newly_solved = not solved_before;
 
-        for (int i = selected_nodes_cnt_ - 2; i >= 0; i--) {
-            const int cur_idx = selected_nodes_[i];
-            auto &node = nodes_[cur_idx];
-            node.visits++;
+        for (int i = (int)path.size() - 2; i >= 0; i--) {
+            const int cur_idx = path[i];
+            auto &&node = nodes_[cur_idx];
+            add_to<concurrent>(node.visits, 1);
 
             if (status == 2) {
-                node.score_sum += score;
+                add_to<concurrent>(node.score_sum, score);
                 score = -score;
                 continue;
             }
 
+            //* proved by another thread after select(), its parent already
+            //* counted it, nodes above only get visits and score
+            if (node.is_solved()) {
+                score = -node.nn_value;
+                status = 2;
+                continue;
+            }
+
             if (status == 1) {
                 node.status = 1;
                 node.nn_value = score;
                 status = -1;
                 score = -score;
+                newly_solved = true;
                 continue;
             }
 
-            if (status == 0) {
-                node.children_draw = 1;
-            }
-
-            // calc number of solved children
-            int solved = 0;
-            for (int i = 0; i < node.child_count; i++) {
-                const auto &child = nodes_[node.child_index + i];
+            //* every solved child is counted once, when it gets solved
+            if (newly_solved) {
+                auto &solved = solved_children(cur_idx);
+                solved.count += 1;
+                solved.value = std::max(solved.value, score);
 
-                solved += child.is_solved();
+                if (status == 0) {
+                    node.children_draw = 1;
+                }
+            } else if (transpositions_.enabled()) {
+                recount_solved_children<concurrent>(cur_idx);
             }
 
-            if (solved == node.child_count) {
-                node.status = status;
-                node.nn_value = max_solved_child_nn_value(cur_idx);
+            const auto &solved = solved_children(cur_idx);
+
+            if (solved.count == node.child_count) {
+                //* one drawing child is enough to not lose
+                node.status = node.children_draw ? 0 : -1;
+                node.nn_value = solved.value;
                 score = -node.nn_value;
-                status = -status;
+                status = -node.status;
+                newly_solved = true;
             } else {
                 //* node isn't solved yet
-                node.score_sum += score;
+                add_to<concurrent>(node.score_sum, score);
                 status = 2;
                 score = -score;
             }
         }
     }
 
-    int select() {
+    template <bool concurrent = false>
+    int select(std::vector<uint32_t> &path) {
         int node_idx = root_idx_;
-        selected_nodes_cnt_ = 0;
+        path.clear();
 
         while (true) {
-            if (selected_nodes_.size() == selected_nodes_cnt_) {
-                selected_nodes_.emplace_back(0);
-            }
-
-            selected_nodes_[selected_nodes_cnt_++] = node_idx;
+            path.push_back(node_idx);
 
-            auto &node = nodes_[node_idx];
+            auto &&node = nodes_[node_idx];
 
             if (node.is_solved()) {
                 return node_idx;
             }
 
+            if constexpr (concurrent) {
+                //* children are written before child_count is published
+                if (load_child_count(node.child_count) <= 0) {
+                    return node_idx;
+                }
+            }
+
             // std::cerr << "node_idx: " << node_idx;
             // std::cerr << " child_count:" << node.child_count;
             // std::cerr << " child_index:" << node.child_index;
             // std::cerr << " visits:" << node.visits;
             // std::cerr << "\n";
 
-            if (node.child_count == 0) {
+            //* not expanded yet or pending in batch
+            if (node.child_count <= 0) {
                 return node_idx;
             }
 
-            if (node.child_count == 1) {
+            //* sequential halving decides which root move is searched
+            if (node_idx == root_idx_ and forced_root_child_ >= 0) {
+                node_idx = node.child_index + forced_root_child_;
+                continue;
+            }
+
+            if (node.child_count == 1 and node.child_index >= 0) {
                 node_idx = node.child_index;
                 continue;
             }
 
+            if (node.child_count == 1) {
+                node_idx = edge_node<concurrent>(-node.child_index - 1);
+
+                if (node_idx < 0) {
+                    //* out of reserved nodes
+                    return path.back();
+                }
+
+                continue;
+            }
+
             const float cpuct = config_.cpuct_init;
 
             // std::cerr << cpuct << "\n";
@@ -698,30 +2520,14 @@ class MCTS {
 
             // std::cerr << "parent_value: " << parent_value << "\n";
 
-            float best_U = -1e9f;
-            int best_child = -1;
-
             assert(node.child_count > 0);
 
-            for (int i = 0; i < node.child_count; i++) {
-                auto &child = nodes_[node.child_index + i];
-
-                if (child.status == 1) {
-                    // skip solved lose nodes
-                    continue;
-                }
-
-                const float Q = -child.get_value();
-                const float P =
-                    parent_value * child.policy * fastinv(1 + child.visits);
-
-                const float U = Q + P;
-
-                if (U > best_U) {
-                    best_U = U;
-                    best_child = i;
-                }
-            }
+            const int best_child =
+                node.child_index < 0
+                    ? select_edge<concurrent>(-node.child_index - 1,
+                                              node.child_count, parent_value)
+                    : select_child(node.child_index, node.child_count,
+                                   parent_value);
 
             // if (best_child == -1) {
             //     std::cerr << node_idx << " " << root_idx_ << "\n";
@@ -743,18 +2549,217 @@ class MCTS {
             //     }
             // }
 
-            assert(best_child != -1);
-            node_idx = node.child_index + best_child;
+            if (best_child == -1) {
+                //* children shared with transposition were solved through
+                //* its parent, every move loses
+                node.nn_value = max_solved_child_nn_value<concurrent>(node_idx);
+                node.status = -1;
+                return node_idx;
+            }
+
+            if (node.child_index >= 0) {
+                node_idx = node.child_index + best_child;
+                continue;
+            }
+
+            //* child of lazy block gets node on first selection
+            node_idx =
+                edge_node<concurrent>(-node.child_index - 1 + best_child);
+
+            if (node_idx < 0) {
+                //* out of reserved nodes
+                return path.back();
+            }
         }
 
         assert(0);
     }
 
+    /*
+        Lazy block version of select_child(). Child without node wasn't
+        selected yet, so it's scored like new MCTSNode with 0 visits.
+    */
+    template <bool concurrent>
+    int select_edge(int first_edge, int count, float parent_value) const {
+        float best_U = -1e9f;
+        int best_child = -1;
+
+        for (int i = 0; i < count; i++) {
+            const auto &edge = edges_[first_edge + i];
+            const int child_idx = child_node<concurrent>(-first_edge - 1, i);
+
+            float Q = -1.0f;
+            float P = parent_value * edge.policy * fastinv(1);
+
+            if (child_idx >= 0) {
+                const auto &child = nodes_[child_idx];
+
+                if (child.status == 1) {
+                    // skip solved lose nodes
+                    continue;
+                }
+
+                Q = -child.get_value();
+                P = parent_value * child.policy * fastinv(1 + child.visits);
+            }
+
+            const float U = Q + P;
+
+            if (U > best_U) {
+                best_U = U;
+                best_child = i;
+            }
+        }
+
+        return best_child;
+    }
+
+#ifdef MCTS_SOA_NODES
+    /*
+        Same PUCT as scalar select_child(), 8 children per iteration.
+        Returns -1 if every child is solved lose.
+    */
+    int select_child(int first, int count, float parent_value) const {
+        const float *score_sum = nodes_.score_sum_data() + first;
+        const float *nn_value = nodes_.nn_value_data() + first;
+        const float *policy = nodes_.policy_data() + first;
+        const int *visits = nodes_.visits_data() + first;
+        const int *status = nodes_.status_data() + first;
+
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 skipped = _mm256_set1_ps(-1e30f);
+        const __m256 parent = _mm256_set1_ps(parent_value);
+        const __m256i not_solved = _mm256_set1_epi32(2);
+        const __m256i lose = _mm256_set1_epi32(1);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        float best_U = -1e9f;
+        int best_child = -1;
+
+        for (int i = 0; i < count; i += 8) {
+            //* lanes past the last child aren't loaded
+            const __m256i in_block = _mm256_cmpgt_epi32(
+                _mm256_set1_epi32(count - i), lanes);
+
+            const __m256i visits_i =
+                _mm256_maskload_epi32(visits + i, in_block);
+            const __m256i status_i =
+                _mm256_maskload_epi32(status + i, in_block);
+            const __m256 score_v =
+                _mm256_maskload_ps(score_sum + i, in_block);
+            const __m256 nn_value_v =
+                _mm256_maskload_ps(nn_value + i, in_block);
+            const __m256 policy_v = _mm256_maskload_ps(policy + i, in_block);
+            const __m256 visits_v = _mm256_cvtepi32_ps(visits_i);
+
+            //* MCTSNode::get_value
+            __m256 value = _mm256_div_ps(score_v, visits_v);
+            value = _mm256_blendv_ps(
+                value, one, _mm256_cmp_ps(visits_v, zero, _CMP_EQ_OQ));
+            value = _mm256_blendv_ps(
+                nn_value_v, value,
+                _mm256_castsi256_ps(_mm256_cmpeq_epi32(status_i, not_solved)));
+
+            const __m256 P = _mm256_mul_ps(
+                _mm256_mul_ps(parent, policy_v),
+                _mm256_rcp_ps(_mm256_add_ps(one, visits_v)));
+
+            __m256 U = _mm256_sub_ps(P, value);
+
+            //* skip solved lose nodes
+            const __m256i skip = _mm256_or_si256(
+                _mm256_cmpeq_epi32(status_i, lose),
+                _mm256_xor_si256(in_block, _mm256_set1_epi32(-1)));
+            U = _mm256_blendv_ps(U, skipped, _mm256_castsi256_ps(skip));
+
+            //* horizontal max, first lane with it wins like in scalar loop
+            __m256 max = _mm256_max_ps(U, _mm256_permute2f128_ps(U, U, 1));
+            max = _mm256_max_ps(
+                max, _mm256_shuffle_ps(max, max, _MM_SHUFFLE(1, 0, 3, 2)));
+            max = _mm256_max_ps(
+                max, _mm256_shuffle_ps(max, max, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            const float block_best = _mm256_cvtss_f32(max);
+
+            if (block_best > best_U) {
+                const int mask =
+                    _mm256_movemask_ps(_mm256_cmp_ps(U, max, _CMP_EQ_OQ));
+                best_U = block_best;
+                best_child = i + __builtin_ctz(mask);
+            }
+        }
+
+        return best_child;
+    }
+
+#else
+    //* returns -1 if every child is solved lose
+    int select_child(int first, int count, float parent_value) const {
+        float best_U = -1e9f;
+        int best_child = -1;
+
+        for (int i = 0; i < count; i++) {
+            const auto &child = nodes_[first + i];
+
+            if (child.status == 1) {
+                // skip solved lose nodes
+                continue;
+            }
+
+            const float Q = -child.get_value();
+            const float P =
+                parent_value * child.policy * fastinv(1 + child.visits);
+
+            const float U = Q + P;
+
+            if (U > best_U) {
+                best_U = U;
+                best_child = i;
+            }
+        }
+
+        return best_child;
+    }
+#endif
+
     MCTSConfig config_;
-    std::vector<MCTSNode> nodes_;
+    MCTSNodes nodes_;
     size_t nodes_count_;
     std::vector<uint32_t> selected_nodes_;  // used in backpropagation
-    int selected_nodes_cnt_;
+    std::vector<std::vector<uint32_t>> batch_paths_;
+    std::vector<std::vector<int>> batch_legal_moves_;
+    std::vector<uint64_t> batch_keys_;
+    std::vector<MCTSNode> compact_buffer_;
+    std::vector<std::pair<int, int>> prune_candidates_;  // visits, children
+    std::vector<uint32_t> node_remap_;
+    std::vector<MCTSEdge> edges_;  // children of lazy blocks
+    std::vector<MCTSEdge> compact_edges_;
+    std::vector<uint32_t> edge_remap_;
+    size_t edges_count_;
+    ScratchState scratch_;  // state of last selected leaf
+    TranspositionTable transpositions_;
+    uint32_t root_ply_;
+    long long abandoned_visits_;  // of old roots since last compaction
+    //* indexed like nodes_, used only by solver
+    std::vector<SolvedChildren> solved_children_;
+    std::vector<SolvedChildren> compact_solved_children_;
+    std::mutex solver_mutex_;
+    std::atomic<bool> out_of_nodes_;
+    int saved_simulations_;  // by smart stop in last search
+    int last_simulations_;   // root visits added by last search
+    long long last_search_us_;
+    std::thread ponder_thread_;
+    std::atomic<bool> pondering_;
+    int ponder_simulations_;
+    int forced_root_child_;  // root move searched by sequential halving
+    int gumbel_move_;  // move chosen by last Gumbel search, -1 if none
+    std::vector<float> dirichlet_noise_;  // gamma samples of root children
+    std::vector<float> gumbel_noise_;  // gumbel + log(prior) of root children
+    std::vector<float> gumbel_scores_;
+    std::vector<int> gumbel_candidates_;
     uint32_t root_idx_;
-    Game root_gamestate_;
-};
\ No newline at end of file
+    GameState root_gamestate_;
+};
+
+using MCTS = BasicMCTS<Game>;
\ No newline at end of file
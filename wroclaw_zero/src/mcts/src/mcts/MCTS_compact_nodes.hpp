@@ -0,0 +1,176 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "MCTS_node.hpp"
+
+/*
+    Packed node, 20 bytes instead of 36 of MCTSNode:
+    policy and nn_value as fp16, 16 bit move and one 16 bit word with
+    child_count (13 bits), children_draw (1 bit) and status (2 bits).
+    score_sum, visits and child_index stay 32 bit.
+*/
+struct MCTSCompactNode {
+    float score_sum;
+    int visits;
+    int child_index;
+    uint16_t policy;
+    uint16_t nn_value;
+    uint16_t move;
+    uint16_t meta;
+};
+
+static_assert(sizeof(MCTSCompactNode) == 20);
+
+//* fp16 field seen as float
+template <class Word>
+struct MCTSHalfRef {
+    Word &bits;
+
+    operator float() const { return _cvtsh_ss(bits); }
+
+    const MCTSHalfRef &operator=(float x) const {
+        bits = _cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT);
+        return *this;
+    }
+
+    const MCTSHalfRef &operator=(const MCTSHalfRef &other) const {
+        return *this = (float)other;
+    }
+};
+
+//* Bits wide field of word seen as int, stored value is x + Bias
+template <class Word, int Shift, int Bits, bool Signed, int Bias = 0>
+struct MCTSBitsRef {
+    Word &word;
+
+    operator int() const {
+        int x = (word >> Shift) & ((1 << Bits) - 1);
+        if (Signed and x >= (1 << (Bits - 1))) {
+            x -= 1 << Bits;
+        }
+        return x - Bias;
+    }
+
+    const MCTSBitsRef &operator=(int x) const {
+        constexpr int mask = ((1 << Bits) - 1) << Shift;
+        word = (word & ~mask) | (((x + Bias) << Shift) & mask);
+        return *this;
+    }
+
+    const MCTSBitsRef &operator=(const MCTSBitsRef &other) const {
+        return *this = (int)other;
+    }
+};
+
+/*
+    Reference to node stored in MCTSCompactNodes, same fields as MCTSNode.
+    child_count is -1 for pending leaf, status is -1..2.
+*/
+template <class Node, class Word>
+struct MCTSCompactNodeRef {
+    std::conditional_t<std::is_const_v<Node>, const float, float> &score_sum;
+    MCTSHalfRef<Word> nn_value;
+    MCTSHalfRef<Word> policy;
+    std::conditional_t<std::is_const_v<Node>, const int, int> &visits;
+    Word &move;
+    std::conditional_t<std::is_const_v<Node>, const int, int> &child_index;
+    MCTSBitsRef<Word, 0, 13, true> child_count;
+    MCTSBitsRef<Word, 13, 1, false> children_draw;
+    MCTSBitsRef<Word, 14, 2, false, 1> status;
+
+    explicit MCTSCompactNodeRef(Node &node)
+        : score_sum(node.score_sum),
+          nn_value{node.nn_value},
+          policy{node.policy},
+          visits(node.visits),
+          move(node.move),
+          child_index(node.child_index),
+          child_count{node.meta},
+          children_draw{node.meta},
+          status{node.meta} {}
+
+    const MCTSCompactNodeRef &operator=(const MCTSNode &node) const {
+        score_sum = node.score_sum;
+        nn_value = node.nn_value;
+        policy = node.policy;
+        visits = node.visits;
+        move = node.move;
+        child_index = node.child_index;
+        child_count = node.child_count;
+        children_draw = node.children_draw;
+        status = node.status;
+        return *this;
+    }
+
+    operator MCTSNode() const {
+        MCTSNode node(move, policy);
+        node.score_sum = score_sum;
+        node.nn_value = nn_value;
+        node.visits = visits;
+        node.child_index = child_index;
+        node.child_count = child_count;
+        node.status = status;
+        node.children_draw = children_draw;
+        return node;
+    }
+
+    inline bool is_solved() const { return status != 2; }
+
+    float get_value() const {
+        if (status != 2) {
+            return nn_value;
+        }
+
+        if (visits == 0) return 1;
+        if (visits == 1) return score_sum;
+        return score_sum / (float)visits;
+    }
+};
+
+/*
+    Node storage with MCTSCompactNode, for big trees where memory bandwidth
+    matters more than exact policy. Packed fields can't be updated
+    atomically, so it works with single threaded search only.
+    Interface is the subset of std::vector<MCTSNode> used by MCTS.
+*/
+class MCTSCompactNodes {
+   public:
+    using Ref = MCTSCompactNodeRef<MCTSCompactNode, uint16_t>;
+    using ConstRef = MCTSCompactNodeRef<const MCTSCompactNode, const uint16_t>;
+
+    inline Ref operator[](size_t idx) { return Ref(nodes_[idx]); }
+
+    inline ConstRef operator[](size_t idx) const {
+        return ConstRef(nodes_[idx]);
+    }
+
+    void emplace_back(int move, float policy) {
+        nodes_.emplace_back();
+        (*this)[nodes_.size() - 1] = MCTSNode(move, policy);
+    }
+
+    void resize(size_t size) {
+        const size_t old_size = nodes_.size();
+
+        nodes_.resize(size);
+
+        for (size_t i = old_size; i < size; i++) {
+            (*this)[i] = MCTSNode();
+        }
+    }
+
+    void reserve(size_t size) { nodes_.reserve(size); }
+
+    inline size_t size() const { return nodes_.size(); }
+
+    inline size_t capacity() const { return nodes_.capacity(); }
+
+   private:
+    std::vector<MCTSCompactNode> nodes_;
+};
@@ -11,6 +11,22 @@ struct MCTSConfig {
     float temperature_max = 1.75;
     float temperature_min = 0.5;
     int init_reserved_nodes = 0;
+    int max_nodes = 0;  // hard node budget, least visited subtrees are pruned
+    int batch_size = 1;  // number of leaves evaluated in one forward
+    float virtual_loss = 1.0f;  // used only when batch_size > 1
+    int search_threads = 1;  // threads sharing one tree, one model each
+    int transposition_table_size = 0;  // 0 disables transpositions
+    float compact_threshold = 0.5f;  // abandoned fraction of tree, > 1 never
+    bool lazy_children = false;  // allocate children on first visit of node
+    float smart_stop = 0.0f;  // 0 disables, 1 stops when best move is decided
+    float full_search_probability = 1.0f;  // self play moves that are samples
+    int fast_iterations_per_turn = 100;  // budget of moves that aren't samples
+    bool gumbel = false;  // Gumbel root search instead of noise and visits
+    int gumbel_actions = 16;  // root moves sampled for sequential halving
+    float gumbel_c_visit = 50.0f;
+    float gumbel_c_scale = 1.0f;
+    int seed = -1;  // >= 0 makes self play and pit play games reproducible
+    bool incremental_accumulator = false;  // first layer updated by moves
 
     MCTSConfig() {}
 };
@@ -1,14 +1,43 @@
 #pragma once
 
+/*
+    Field written by one search thread while others read it (solver status
+    and value in tree-parallel search). Every access is relaxed atomic,
+    which compiles to plain load or store of aligned int or float.
+*/
+template <class T>
+class Relaxed {
+   public:
+    Relaxed(T value = T()) : value_(value) {}
+
+    Relaxed(const Relaxed &other) : value_(other) {}
+
+    Relaxed &operator=(const Relaxed &other) { return *this = (T)other; }
+
+    Relaxed &operator=(T value) {
+        __atomic_store(&value_, &value, __ATOMIC_RELAXED);
+        return *this;
+    }
+
+    operator T() const {
+        T value;
+        __atomic_load(&value_, &value, __ATOMIC_RELAXED);
+        return value;
+    }
+
+   private:
+    T value_;
+};
+
 struct MCTSNode {
     float score_sum;
-    float nn_value;
+    Relaxed<float> nn_value;
     float policy;
     int visits;
     int move;
     int child_index;
     int child_count;
-    int status;  //? for solver, 2 if not solved
+    Relaxed<int> status;  //? for solver, 2 if not solved
     int children_draw;
 
     MCTSNode()
@@ -54,4 +83,11 @@ struct MCTSNode {
         if (visits == 1) return score_sum;
         return score_sum / (float)visits;
     }
-};
\ No newline at end of file
+};
+
+//* child of lazy expanded node, node = -1 until it's selected first time
+struct MCTSEdge {
+    int move;
+    float policy;
+    int node;
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "MCTS_node.hpp"
+
+/*
+    Reference to node stored in MCTSSoANodes. Has the same fields as
+    MCTSNode, so MCTS code works with both layouts through auto &&node.
+*/
+template <class Float, class Int>
+struct MCTSNodeRef {
+    //* const Relaxed<T> for const T
+    template <class T>
+    using RelaxedRef = std::conditional_t<std::is_const_v<T>,
+                                          const Relaxed<std::remove_const_t<T>>,
+                                          Relaxed<T>> &;
+
+    Float &score_sum;
+    RelaxedRef<Float> nn_value;
+    Float &policy;
+    Int &visits;
+    Int &move;
+    Int &child_index;
+    Int &child_count;
+    RelaxedRef<Int> status;
+    Int &children_draw;
+
+    const MCTSNodeRef &operator=(const MCTSNode &node) const {
+        score_sum = node.score_sum;
+        nn_value = node.nn_value;
+        policy = node.policy;
+        visits = node.visits;
+        move = node.move;
+        child_index = node.child_index;
+        child_count = node.child_count;
+        status = node.status;
+        children_draw = node.children_draw;
+        return *this;
+    }
+
+    operator MCTSNode() const {
+        MCTSNode node(move, policy);
+        node.score_sum = score_sum;
+        node.nn_value = nn_value;
+        node.visits = visits;
+        node.child_index = child_index;
+        node.child_count = child_count;
+        node.status = status;
+        node.children_draw = children_draw;
+        return node;
+    }
+
+    inline bool is_solved() const { return status != 2; }
+
+    float get_value() const {
+        if (status != 2) {
+            return nn_value;
+        }
+
+        if (visits == 0) return 1;
+        if (visits == 1) return score_sum;
+        return score_sum / (float)visits;
+    }
+};
+
+/*
+    Structure of arrays node storage. Children of one parent are contiguous,
+    so their statistics are contiguous in every array and select() can
+    compute PUCT for 8 children at once.
+    Interface is the subset of std::vector<MCTSNode> used by MCTS.
+*/
+class MCTSSoANodes {
+   public:
+    using Ref = MCTSNodeRef<float, int>;
+    using ConstRef = MCTSNodeRef<const float, const int>;
+
+    inline Ref operator[](size_t idx) {
+        return Ref{score_sum_[idx],   nn_value_[idx],
+                   policy_[idx],      visits_[idx],
+                   move_[idx],        child_index_[idx],
+                   child_count_[idx], status_[idx],
+                   children_draw_[idx]};
+    }
+
+    inline ConstRef operator[](size_t idx) const {
+        return ConstRef{score_sum_[idx],   nn_value_[idx],
+                        policy_[idx],      visits_[idx],
+                        move_[idx],        child_index_[idx],
+                        child_count_[idx], status_[idx],
+                        children_draw_[idx]};
+    }
+
+    void emplace_back(int move, float policy) {
+        MCTSNode node(move, policy);
+        score_sum_.push_back(node.score_sum);
+        nn_value_.push_back(node.nn_value);
+        policy_.push_back(node.policy);
+        visits_.push_back(node.visits);
+        move_.push_back(node.move);
+        child_index_.push_back(node.child_index);
+        child_count_.push_back(node.child_count);
+        status_.push_back(node.status);
+        children_draw_.push_back(node.children_draw);
+    }
+
+    void resize(size_t size) {
+        const size_t old_size = visits_.size();
+
+        score_sum_.resize(size);
+        nn_value_.resize(size);
+        policy_.resize(size);
+        visits_.resize(size);
+        move_.resize(size);
+        child_index_.resize(size);
+        child_count_.resize(size);
+        status_.resize(size);
+        children_draw_.resize(size);
+
+        for (size_t i = old_size; i < size; i++) {
+            (*this)[i] = MCTSNode();
+        }
+    }
+
+    void reserve(size_t size) {
+        score_sum_.reserve(size);
+        nn_value_.reserve(size);
+        policy_.reserve(size);
+        visits_.reserve(size);
+        move_.reserve(size);
+        child_index_.reserve(size);
+        child_count_.reserve(size);
+        status_.reserve(size);
+        children_draw_.reserve(size);
+    }
+
+    inline size_t size() const { return visits_.size(); }
+
+    inline size_t capacity() const { return visits_.capacity(); }
+
+    //* bytes of one node in all arrays
+    static constexpr size_t node_bytes() {
+        return sizeof(decltype(score_sum_)::value_type) +
+               sizeof(decltype(nn_value_)::value_type) +
+               sizeof(decltype(policy_)::value_type) +
+               sizeof(decltype(visits_)::value_type) +
+               sizeof(decltype(move_)::value_type) +
+               sizeof(decltype(child_index_)::value_type) +
+               sizeof(decltype(child_count_)::value_type) +
+               sizeof(decltype(status_)::value_type) +
+               sizeof(decltype(children_draw_)::value_type);
+    }
+
+    inline const float *score_sum_data() const { return score_sum_.data(); }
+    //* Relaxed has layout of its value, SIMD select reads arrays directly
+    inline const float *nn_value_data() const {
+        return reinterpret_cast<const float *>(nn_value_.data());
+    }
+    inline const float *policy_data() const { return policy_.data(); }
+    inline const int *visits_data() const { return visits_.data(); }
+    inline const int *status_data() const {
+        return reinterpret_cast<const int *>(status_.data());
+    }
+
+   private:
+    std::vector<float> score_sum_;
+    std::vector<Relaxed<float>> nn_value_;
+    std::vector<float> policy_;
+    std::vector<int> visits_;
+    std::vector<int> move_;
+    std::vector<int> child_index_;
+    std::vector<int> child_count_;
+    std::vector<Relaxed<int>> status_;
+    std::vector<int> children_draw_;
+};
@@ -8,23 +8,35 @@
 #include <vector>
 
 #include "MCTS.hpp"
-
-class PitPlayWorker {
+#include "random.hpp"
+
+/*
+    GameState is Game or concrete game, same as in BasicMCTS.
+    ms = -1 searches number_of_iterations_per_turn, otherwise ms is limit
+    of one move. With game_ms every player has clock for whole game and
+    time manager decides about time of every move.
+*/
+template <class GameState>
+class BasicPitPlayWorker {
    public:
-    PitPlayWorker(Game game, const ModelFactory& factory1, MCTSConfig config1,
+    BasicPitPlayWorker(GameState game, const ModelFactory& factory1, MCTSConfig config1,
                   const ModelFactory& factory2, MCTSConfig config2, int games,
-                  int threads_number, bool verbose = false, int ms = -1) {
+                  int threads_number, bool verbose = false, int ms = -1,
+                  int game_ms = -1) {
         games_to_play_ = games;
         games_played_ = 0;
         verbose_ = verbose;
         games_length_ = 0;
+        saved_simulations_ = 0;
         p2_wins_ = p1_wins_ = draws_ = 0;
         ms_ = ms;
+        game_ms_ = game_ms;
 
         std::vector<std::thread> threads(threads_number);
-        for (auto& thread : threads) {
-            thread = std::thread(&PitPlayWorker::work, this, game, factory1,
-                                 config1, factory2, config2);
+        for (int i = 0; i < threads_number; i++) {
+            threads[i] = std::thread(&BasicPitPlayWorker::work, this, i,
+                                     threads_number, game, factory1, config1,
+                                     factory2, config2);
         }
 
         for (auto& thread : threads) {
@@ -45,6 +57,11 @@ class PitPlayWorker {
                       << " draws: " << draws_ << "\n";
             std::cerr << "Model2 stats: WR: " << p2_wr << " wins: " << p2_wins_
                       << " draws: " << draws_ << "\n";
+
+            if (saved_simulations_ > 0) {
+                std::cerr << "Simulations saved by smart stop: "
+                          << saved_simulations_ << "\n";
+            }
         }
     }
 
@@ -57,23 +74,41 @@ class PitPlayWorker {
         return (float)games_length_ / (float)games_to_play_;
     }
 
+    long long get_saved_simulations() const { return saved_simulations_; }
+
    private:
-    void work(Game game, const ModelFactory& factory1, MCTSConfig config1,
+    //* seed >= 0 fixes games of every thread, same as in self play
+    void work(int thread_idx, int threads, GameState game,
+              const ModelFactory& factory1, MCTSConfig config1,
               const ModelFactory& factory2, MCTSConfig config2) {
-        Model model1 = factory1();
-        Model model2 = factory2();
+        //* one model per search thread
+        std::vector<Model> models1, models2;
+        for (int i = 0; i < std::max(1, config1.search_threads); i++) {
+            models1.push_back(factory1());
+        }
+
+        for (int i = 0; i < std::max(1, config2.search_threads); i++) {
+            models2.push_back(factory2());
+        }
+
+        const bool seeded = config1.seed >= 0;
+        int next_game = thread_idx;
 
         while (true) {
             bool player1_starts = false;
+            int game_idx;
 
             {
                 std::lock_guard<std::mutex> guard(mutex_);
 
-                if (games_played_ >= games_to_play_) {
+                game_idx = seeded ? next_game : games_played_;
+                next_game += threads;
+
+                if (game_idx >= games_to_play_) {
                     break;
                 }
 
-                player1_starts = (games_played_ % 2);
+                player1_starts = (game_idx % 2);
 
                 if (verbose_) {
                     display_progress_bar();
@@ -82,31 +117,45 @@ class PitPlayWorker {
                 games_played_++;
             }
 
-            MCTS player1(game, config1);
-            MCTS player2(game, config2);
+            if (seeded) {
+                Random::instance().seed(
+                    Random::stream_seed(config1.seed, game_idx));
+            }
+
+            BasicMCTS<GameState> player1(game, config1);
+            BasicMCTS<GameState> player2(game, config2);
 
-            MCTS* p0 = (player1_starts ? &player1 : &player2);
-            MCTS* p1 = (player1_starts ? &player2 : &player1);
-            Model* m0 = (player1_starts ? &model1 : &model2);
-            Model* m1 = (player1_starts ? &model2 : &model1);
+            BasicMCTS<GameState>* p0 = (player1_starts ? &player1 : &player2);
+            BasicMCTS<GameState>* p1 = (player1_starts ? &player2 : &player1);
+            auto* m0 = (player1_starts ? &models1 : &models2);
+            auto* m1 = (player1_starts ? &models2 : &models1);
 
-            Game state = game->clone();
+            GameState state = clone_game(game);
             int game_length = 0;
 
+            const int moves_to_go =
+                game_ref(game).get_maximum_number_of_turns() / 2;
+            const int move_ms = (ms_ != -1 ? ms_ : game_ms_);
+            TimeManager time0(game_ms_, move_ms, moves_to_go);
+            TimeManager time1(game_ms_, move_ms, moves_to_go);
+            long long saved_simulations = 0;
+
             while (true) {
-                (ms_ != -1 ? p0->search(*m0, ms_) : p0->search(*m0));
+                search(*p0, *m0, time0);
+                saved_simulations += p0->get_saved_simulations();
                 const int p0_move = p0->get_best();
-                p0->restore_root(p0_move, *m0);
-                p1->restore_root(p0_move, *m1);
-                state->make_move(p0_move);
+                p0->restore_root(p0_move, m0->front());
+                p1->restore_root(p0_move, m1->front());
+                game_ref(state).make_move(p0_move);
                 game_length++;
 
-                if (state->is_terminal()) {
-                    auto result = -state->get_game_result();
+                if (game_ref(state).is_terminal()) {
+                    auto result = -game_ref(state).get_game_result();
 
                     std::lock_guard<std::mutex> guard(mutex_);
 
                     games_length_ += game_length;
+                    saved_simulations_ += saved_simulations;
 
                     if (result == 1) {
                         (player1_starts ? p1_wins_ : p2_wins_)++;
@@ -119,19 +168,21 @@ class PitPlayWorker {
                     break;
                 }
 
-                (ms_ != -1 ? p1->search(*m1, ms_) : p1->search(*m1));
+                search(*p1, *m1, time1);
+                saved_simulations += p1->get_saved_simulations();
                 const int p1_move = p1->get_best();
-                p0->restore_root(p1_move, *m0);
-                p1->restore_root(p1_move, *m1);
-                state->make_move(p1_move);
+                p0->restore_root(p1_move, m0->front());
+                p1->restore_root(p1_move, m1->front());
+                game_ref(state).make_move(p1_move);
                 game_length++;
 
-                if (state->is_terminal()) {
-                    auto result = -state->get_game_result();
+                if (game_ref(state).is_terminal()) {
+                    auto result = -game_ref(state).get_game_result();
 
                     std::lock_guard<std::mutex> guard(mutex_);
 
                     games_length_ += game_length;
+                    saved_simulations_ += saved_simulations;
 
                     if (result == 1) {
                         (player1_starts ? p2_wins_ : p1_wins_)++;
@@ -147,6 +198,17 @@ class PitPlayWorker {
         }
     }
 
+    void search(BasicMCTS<GameState>& mcts, std::vector<Model>& models,
+                TimeManager& time) {
+        if (game_ms_ != -1) {
+            mcts.search(models, time);
+        } else if (ms_ != -1) {
+            mcts.search(models, ms_);
+        } else {
+            mcts.search(models);
+        }
+    }
+
     void display_progress_bar() {
         if (games_played_ % 100 != 0 and games_played_ != games_to_play_) {
             return;
@@ -189,7 +251,11 @@ class PitPlayWorker {
     int games_to_play_;
     int games_played_;
     int games_length_;
+    long long saved_simulations_;
     int ms_;
+    int game_ms_;
     bool verbose_;
     std::mutex mutex_;
-};
\ No newline at end of file
+};
+
+using PitPlayWorker = BasicPitPlayWorker<Game>;
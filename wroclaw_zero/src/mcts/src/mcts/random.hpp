@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <cstdint>
 #include <limits>
 #include <random>
@@ -19,11 +20,23 @@ class Random {
         setSeed(e2);
     }
 
+    //* every thread has its own stream, no shared state between workers
     static Random &instance() {
-        static Random random;
+        static thread_local Random random;
         return random;
     }
 
+    //* same seed gives same stream, close seeds give unrelated streams
+    void seed(uint64_t seed) {
+        m_seed = splitmix64(seed);
+        has_normal_ = false;
+    }
+
+    //* seed of stream number stream derived from one base seed
+    static uint64_t stream_seed(uint64_t seed, uint64_t stream) {
+        return splitmix64(seed ^ splitmix64(stream + 1));
+    }
+
     void setSeed(std::mt19937 &e2) {
         std::uniform_int_distribution<int32_t> dist(
             std::numeric_limits<int32_t>::min(),
@@ -62,8 +75,84 @@ class Random {
         return next_float() * (b - a) + a;
     }
 
+    //* uniform in (0, 1), safe for log
+    inline float next_open_float() {
+        return ((xrandom() >> 8) + 0.5f) * (1.0f / 16777216.0f);
+    }
+
+    //* standard normal, Marsaglia polar method
+    float next_normal() {
+        if (has_normal_) {
+            has_normal_ = false;
+            return next_normal_;
+        }
+
+        float u, v, s;
+        do {
+            u = next_float(-1.0f, 1.0f);
+            v = next_float(-1.0f, 1.0f);
+            s = u * u + v * v;
+        } while (s >= 1.0f or s == 0.0f);
+
+        const float factor = std::sqrt(-2.0f * std::log(s) / s);
+        next_normal_ = v * factor;
+        has_normal_ = true;
+
+        return u * factor;
+    }
+
+    /*
+        Gamma(alpha, 1), Marsaglia-Tsang squeeze accepts almost every
+        sample with one normal and one uniform. For alpha < 1 (usual
+        dirichlet alpha) Gamma(alpha + 1) * U^(1 / alpha) is used.
+    */
+    float next_gamma(float alpha) {
+        float boost = 1.0f;
+
+        if (alpha < 1.0f) {
+            boost = std::pow(next_open_float(), 1.0f / alpha);
+            alpha += 1.0f;
+        }
+
+        const float d = alpha - 1.0f / 3.0f;
+        const float c = 1.0f / std::sqrt(9.0f * d);
+
+        while (true) {
+            float x, v;
+            do {
+                x = next_normal();
+                v = 1.0f + c * x;
+            } while (v <= 0.0f);
+
+            v = v * v * v;
+            const float u = next_open_float();
+            const float x2 = x * x;
+
+            if (u < 1.0f - 0.0331f * x2 * x2 or
+                std::log(u) < 0.5f * x2 + d * (1.0f - v + std::log(v))) {
+                return d * v * boost;
+            }
+        }
+    }
+
+    //* n samples of Gamma(alpha, 1), normalized they are Dirichlet(alpha)
+    void fill_gamma(float alpha, float *out, int n) {
+        for (int i = 0; i < n; i++) {
+            out[i] = next_gamma(alpha);
+        }
+    }
+
    private:
+    static uint64_t splitmix64(uint64_t x) {
+        x += 0x9e3779b97f4a7c15;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return x ^ (x >> 31);
+    }
+
     uint64_t m_seed;
+    bool has_normal_ = false;
+    float next_normal_ = 0;
     static const uint64_t K_m = 0x9b60933458e17d7d;
     static const uint64_t K_a = 0xd737232eeccdf7ed;
 };
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//* one move of principal variation, q is value for player making the move
+struct PVMove {
+    int move;
+    int visits;
+    float q;
+    float prior;
+    int status;  //? solver status of node after move, 2 if not solved
+};
+
+/*
+    Snapshot of search returned by BasicMCTS::analyze. Every line starts
+    with one of the most visited root moves and follows most visited
+    child until node without visited children.
+*/
+struct SearchAnalysis {
+    std::vector<std::vector<PVMove>> lines;
+    int root_visits = 0;
+    size_t nodes = 0;            // nodes in subtree of root
+    size_t allocated_nodes = 0;  // also nodes waiting for compaction
+    int depth = 0;               // deepest node below root
+    //* claimed leaves and unexpanded ones with visits (virtual loss), 0
+    //* after search unless max_nodes pruned subtrees to leaves
+    int pending_leaves = 0;
+    int simulations = 0;         // of last search
+    long long search_us = 0;
+    float simulations_per_second = 0;
+};
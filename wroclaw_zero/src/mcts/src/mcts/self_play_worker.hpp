@@ -8,10 +8,13 @@
 #include <vector>
 
 #include "MCTS.hpp"
+#include "random.hpp"
 
-class SelfPlayWorker {
+//* GameState is Game or concrete game, same as in BasicMCTS
+template <class GameState>
+class BasicSelfPlayWorker {
    public:
-    SelfPlayWorker(const Game& game, const ModelFactory& factory1,
+    BasicSelfPlayWorker(const GameState& game, const ModelFactory& factory1,
                    MCTSConfig config1, const ModelFactory& factory2,
                    MCTSConfig config2, int games, int threads_number,
                    bool verbose = false) {
@@ -19,28 +22,42 @@ class SelfPlayWorker {
         games_played_ = 0;
         games_length = 0;
         verbose_ = verbose;
-        first_moves_vis.resize(game->get_maximum_number_of_moves());
+        first_moves_vis.resize(game_ref(game).get_maximum_number_of_moves());
 
-        const int max_samples =
-            games_to_play * game->get_maximum_number_of_turns();
-        const auto input_shape = game->get_input_shape();
-        const auto policy_shape = game->get_maximum_number_of_moves();
+        //* every game writes its samples to its own slot of game_samples
+        max_turns_ = game_ref(game).get_maximum_number_of_turns();
+        const int max_samples = games_to_play * max_turns_;
+        const auto input_shape = game_ref(game).get_input_shape();
+        const auto policy_shape = game_ref(game).get_maximum_number_of_moves();
         game_samples.resize(max_samples, Sample(input_shape, policy_shape));
         game_samples_count = 0;
+        slot_samples_.assign(games_to_play, 0);
 
         auto start = std::chrono::high_resolution_clock::now();
         auto end = std::chrono::high_resolution_clock::now();
 
         std::vector<std::thread> threads(threads_number);
-        for (auto& thread : threads) {
-            thread = std::thread(&SelfPlayWorker::work, this, game, factory1,
-                                 config1, factory2, config2);
+        for (int i = 0; i < threads_number; i++) {
+            threads[i] = std::thread(&BasicSelfPlayWorker::work, this, i,
+                                     threads_number, game, factory1, config1,
+                                     factory2, config2);
         }
 
         for (auto& thread : threads) {
             thread.join();
         }
 
+        //* samples in order of games, independent of thread timing
+        for (int i = 0; i < games_to_play; i++) {
+            for (int j = 0; j < slot_samples_[i]; j++) {
+                if (game_samples_count != i * max_turns_ + j) {
+                    game_samples[game_samples_count] =
+                        std::move(game_samples[i * max_turns_ + j]);
+                }
+                game_samples_count++;
+            }
+        }
+
         if (verbose) {
             display_progress_bar();
 
@@ -72,32 +89,48 @@ class SelfPlayWorker {
     std::vector<Sample> game_samples;
 
    private:
-    void work(const Game& game, const ModelFactory& factory1,
-              MCTSConfig config1, const ModelFactory& factory2,
-              MCTSConfig config2) {
+    /*
+        With seed >= 0 thread plays games thread_idx, thread_idx + threads,
+        ... and every game gets its own random stream, so games and
+        samples don't depend on timing of threads (search_threads = 1 and
+        no time limit). Otherwise threads take next free game.
+    */
+    void work(int thread_idx, int threads, const GameState& game,
+              const ModelFactory& factory1, MCTSConfig config1,
+              const ModelFactory& factory2, MCTSConfig config2) {
         Model model1 = factory1();
         Model model2 = factory2();
 
-        const int max_samples = game->get_maximum_number_of_turns();
-        const auto input_shape = game->get_input_shape();
-        const auto policy_shape = game->get_maximum_number_of_moves();
+        const int max_samples = game_ref(game).get_maximum_number_of_turns();
+        const auto input_shape = game_ref(game).get_input_shape();
+        const auto policy_shape = game_ref(game).get_maximum_number_of_moves();
         std::vector<Sample> samples(max_samples,
                                     Sample(input_shape, policy_shape));
+        //* playout cap randomization, only full searches are samples
+        std::vector<char> full_search(max_samples);
+        Random random;
+
+        BasicMCTS<GameState> player1(game, config1);
+        BasicMCTS<GameState> player2(game, config2);
 
-        MCTS player1(game, config1);
-        MCTS player2(game, config2);
+        const bool seeded = config1.seed >= 0;
+        int next_game = thread_idx;
 
         while (true) {
             bool player1_starts = false;
+            int game_idx;
 
             {
                 std::lock_guard<std::mutex> guard(mutex_);
 
-                if (games_played_ >= games_to_play) {
+                game_idx = seeded ? next_game : games_played_;
+                next_game += threads;
+
+                if (game_idx >= games_to_play) {
                     break;
                 }
 
-                player1_starts = (games_played_ % 2);
+                player1_starts = (game_idx % 2);
 
                 if (verbose_) {
                     display_progress_bar();
@@ -106,23 +139,36 @@ class SelfPlayWorker {
                 games_played_++;
             }
 
+            if (seeded) {
+                const uint64_t game_seed =
+                    Random::stream_seed(config1.seed, game_idx);
+                Random::instance().seed(game_seed);
+                random.seed(game_seed + 1);
+            }
+
             player1.reset(game);
             player2.reset(game);
 
-            MCTS* p0 = (player1_starts ? &player1 : &player2);
-            MCTS* p1 = (player1_starts ? &player2 : &player1);
+            BasicMCTS<GameState>* p0 = (player1_starts ? &player1 : &player2);
+            BasicMCTS<GameState>* p1 = (player1_starts ? &player2 : &player1);
             Model* m0 = (player1_starts ? &model1 : &model2);
             Model* m1 = (player1_starts ? &model2 : &model1);
+            const MCTSConfig* c0 = (player1_starts ? &config1 : &config2);
+            const MCTSConfig* c1 = (player1_starts ? &config2 : &config1);
             size_t game_length = 0;
 
             int first_move;
 
             while (true) {
                 // Player 0 move
+                full_search[game_length] = set_search_size(*p0, *c0, random);
                 p0->search(*m0);
                 const int p0_move = p0->get_best();
 
-                p0->get_sample(samples[game_length++]);
+                if (full_search[game_length]) {
+                    p0->get_sample(samples[game_length]);
+                }
+                game_length++;
 
                 p0->restore_root(p0_move, *m0);
                 p1->restore_root(p0_move, *m1);
@@ -131,28 +177,33 @@ class SelfPlayWorker {
                     first_move = p0_move;
                 }
 
-                if (p0->get_root_state()->is_terminal()) {
+                if (game_ref(p0->get_root_state()).is_terminal()) {
                     break;
                 }
 
                 // Player 1 move
+                full_search[game_length] = set_search_size(*p1, *c1, random);
                 p1->search(*m1);
                 const int p1_move = p1->get_best();
 
-                p1->get_sample(samples[game_length++]);
+                if (full_search[game_length]) {
+                    p1->get_sample(samples[game_length]);
+                }
+                game_length++;
 
                 p0->restore_root(p1_move, *m0);
                 p1->restore_root(p1_move, *m1);
 
-                if (p0->get_root_state()->is_terminal()) {
+                if (game_ref(p0->get_root_state()).is_terminal()) {
                     break;
                 }
             }
 
             // player1.debug_stats();
             
-            auto result = -p0->get_root_state()->get_game_result();
-            auto score = -p0->get_root_state()->get_scaled_game_result();
+            const auto& final_state = game_ref(p0->get_root_state());
+            auto result = -final_state.get_game_result();
+            auto score = -final_state.get_scaled_game_result();
 
             const float k_min = 0.7;
             float decay = 0;
@@ -181,7 +232,10 @@ class SelfPlayWorker {
                     draws_ += 1;
 
                 for (size_t i = 0; i < game_length; i++) {
-                    game_samples[game_samples_count++] = samples[i];
+                    if (full_search[i]) {
+                        game_samples[game_idx * max_turns_ +
+                                     slot_samples_[game_idx]++] = samples[i];
+                    }
                 }
 
                 first_moves_vis[first_move]++;
@@ -202,6 +256,22 @@ class SelfPlayWorker {
         // }
     }
 
+    /*
+        Playout cap randomization: with full_search_probability search
+        uses number_of_iterations_per_turn and its result is a sample,
+        otherwise fast_iterations_per_turn and move is only played.
+    */
+    static bool set_search_size(BasicMCTS<GameState>& mcts,
+                                const MCTSConfig& config, Random& random) {
+        const bool full = config.full_search_probability >= 1.0f or
+                          random.next_float() < config.full_search_probability;
+
+        mcts.set_iterations_per_turn(full ? config.number_of_iterations_per_turn
+                                          : config.fast_iterations_per_turn);
+
+        return full;
+    }
+
     void display_progress_bar() {
         if (games_played_ % 100 != 0 and games_played_ != games_to_play) {
             return;
@@ -226,7 +296,11 @@ class SelfPlayWorker {
     }
 
     int games_played_;
+    int max_turns_;
+    std::vector<int> slot_samples_;  // samples of every game
     bool verbose_;
 
     std::mutex mutex_;
-};
\ No newline at end of file
+};
+
+using SelfPlayWorker = BasicSelfPlayWorker<Game>;
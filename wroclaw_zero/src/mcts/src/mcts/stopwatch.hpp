@@ -26,6 +26,12 @@ class Stopwatch {
             .count();
     }
 
+    long long elapsed_microseconds() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(NOW() -
+                                                                     c_time)
+            .count();
+    }
+
    private:
     std::chrono::high_resolution_clock::time_point c_time, c_timeout;
 };
\ No newline at end of file
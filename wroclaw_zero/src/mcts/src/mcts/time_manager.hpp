@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+
+/*
+    Splits clock of one player between moves of the game.
+    Every move has optimal time, search can stop there if position is
+    stable, and maximum time it can take when best move keeps changing
+    or two best moves have close values. Forced and solved moves take
+    (almost) nothing, saved time goes to next moves.
+    Early moves get more, time of move decreases linearly with moves left.
+*/
+class TimeManager {
+   public:
+    /*
+        total_ms - clock for whole game (-1 = no clock, only move limit)
+        move_ms - hard limit of one move
+        moves_to_go - expected number of own moves in game
+    */
+    TimeManager(int total_ms, int move_ms, int moves_to_go = 40)
+        : remaining_(total_ms < 0 ? INT_MAX : total_ms),
+          move_ms_(move_ms),
+          moves_to_go_(moves_to_go),
+          moves_played_(0) {}
+
+    //* time of stable move
+    int optimal_time() const {
+        const int moves_left =
+            std::max(min_moves_left_, moves_to_go_ - moves_played_);
+
+        const long long share = 2LL * remaining_ / (moves_left + 1);
+
+        return std::max(
+            1, (int)std::min<long long>(share, move_ms_ * stable_fraction_));
+    }
+
+    //* time of unstable move
+    int maximum_time() const {
+        const long long limit = std::min<long long>(
+            {(long long)move_ms_, (long long)optimal_time() * max_factor_,
+             remaining_ / 2});
+
+        return std::max(optimal_time(), (int)limit);
+    }
+
+    //* search asks after optimal time, q_gap is value gap of two best moves
+    bool can_stop(long long elapsed, bool best_changed, float q_gap) const {
+        if (elapsed >= maximum_time()) {
+            return true;
+        }
+
+        return elapsed >= optimal_time() and not best_changed and
+               q_gap >= close_q_gap_;
+    }
+
+    void spent(long long ms) {
+        if (remaining_ != INT_MAX) {
+            remaining_ = std::max(0LL, remaining_ - ms);
+        }
+
+        moves_played_++;
+    }
+
+    //* -1 stands for no clock
+    int get_remaining() const {
+        return remaining_ == INT_MAX ? -1 : (int)remaining_;
+    }
+
+    void set_move_time(int move_ms) { move_ms_ = move_ms; }
+
+   private:
+    static constexpr int min_moves_left_ = 10;
+    static constexpr float stable_fraction_ = 0.5f;  // of move_ms
+    static constexpr int max_factor_ = 3;            // of optimal time
+    static constexpr float close_q_gap_ = 0.05f;
+
+    long long remaining_;
+    int move_ms_;
+    int moves_to_go_;
+    int moves_played_;
+};
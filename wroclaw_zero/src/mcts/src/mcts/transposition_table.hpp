@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*
+    Maps position keys to indices of expanded nodes.
+    Fixed size, new entry always replaces old one.
+    Entry is stored as (key ^ data, data), so entry torn by concurrent
+    writes fails the key check instead of returning wrong node.
+*/
+class TranspositionTable {
+   public:
+    TranspositionTable() : mask_(0), generation_(1) {}
+
+    //* size is rounded up to power of two, 0 disables table
+    void resize(size_t size) {
+        entries_.clear();
+        mask_ = 0;
+
+        if (size == 0) {
+            return;
+        }
+
+        size_t capacity = 1;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+
+        entries_.assign(capacity, Entry{0, 0});
+        mask_ = capacity - 1;
+    }
+
+    inline bool enabled() const { return not entries_.empty(); }
+
+    //* invalidates all entries in O(1)
+    void clear() { generation_++; }
+
+    void store(uint64_t key, uint32_t node_idx) {
+        auto &entry = entries_[index(key)];
+        const uint64_t data = (uint64_t)generation_ << 32 | node_idx;
+
+        __atomic_store_n(&entry.check, key ^ data, __ATOMIC_RELAXED);
+        __atomic_store_n(&entry.data, data, __ATOMIC_RELAXED);
+    }
+
+    //* remap(old_idx) returns new node index or -1 if node was removed
+    template <class Remap>
+    void remap(const Remap &remap) {
+        for (auto &entry : entries_) {
+            if ((entry.data >> 32) != generation_) {
+                continue;
+            }
+
+            const uint64_t key = entry.check ^ entry.data;
+            const int64_t node_idx = remap(entry.data & 0xFFFFFFFFULL);
+
+            if (node_idx < 0) {
+                entry = Entry{0, 0};
+            } else {
+                store(key, node_idx);
+            }
+        }
+    }
+
+    //* returns -1 if key isn't in table
+    int64_t find(uint64_t key) const {
+        const auto &entry = entries_[index(key)];
+        const uint64_t check = __atomic_load_n(&entry.check, __ATOMIC_RELAXED);
+        const uint64_t data = __atomic_load_n(&entry.data, __ATOMIC_RELAXED);
+
+        if ((check ^ data) != key or (data >> 32) != generation_) {
+            return -1;
+        }
+
+        return data & 0xFFFFFFFFULL;
+    }
+
+   private:
+    struct Entry {
+        uint64_t check;
+        uint64_t data;
+    };
+
+    inline size_t index(uint64_t key) const {
+        return (key ^ key >> 32) & mask_;
+    }
+
+    std::vector<Entry> entries_;
+    size_t mask_;
+    uint32_t generation_;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <nn_avx_fast/common.hpp>
+using namespace nn_avx_fast;
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/*
+    Fixed-size, open-addressing cache of network evaluations keyed by
+    AbstractGame::calc_hash(). Stores value and priors of legal moves only.
+    One cache can be shared by all models with the same weights, every
+    entry is guarded by a sequence lock, so readers never block writers.
+    Fields and priors are accessed with relaxed atomics, so reader racing
+    with writer has no data race and drops the entry when seq changed.
+*/
+class EvaluationCache {
+   public:
+    //* size is rounded up to power of two
+    EvaluationCache(size_t size, int max_moves, int probes = 4)
+        : max_moves_(max_moves), probes_(probes), hits_(0), misses_(0) {
+        size_t capacity = 1;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+
+        mask_ = capacity - 1;
+        entries_.assign(capacity, Entry{0, -1, 0, 0});
+        priors_.assign(capacity * max_moves_, 0);
+    }
+
+    /*
+        On hit writes value and priors of legal moves to output,
+        the same way Model::forward does. Output is clobbered on miss.
+    */
+    bool find(uint64_t key, const int* legal_moves, int legal_moves_cnt,
+              Tensor& output) {
+        for (int probe = 0; probe < probes_; probe++) {
+            const size_t idx = (home(key) + probe) & mask_;
+            auto& entry = entries_[idx];
+
+            const uint32_t seq = __atomic_load_n(&entry.seq, __ATOMIC_ACQUIRE);
+
+            if ((seq & 1) or
+                __atomic_load_n(&entry.key, __ATOMIC_RELAXED) != key) {
+                continue;
+            }
+
+            if (__atomic_load_n(&entry.cnt, __ATOMIC_RELAXED) !=
+                legal_moves_cnt) {
+                break;
+            }
+
+            const float* priors = &priors_[idx * max_moves_];
+            float value;
+            __atomic_load(&entry.value, &value, __ATOMIC_RELAXED);
+
+            output.fill(0);
+            output.set_element(0, value);
+
+            for (int i = 0; i < legal_moves_cnt; i++) {
+                float prior;
+                __atomic_load(&priors[i], &prior, __ATOMIC_RELAXED);
+                output.set_element(legal_moves[i] + 1, prior);
+            }
+
+            //* entry was overwritten while reading
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&entry.seq, __ATOMIC_RELAXED) != seq) {
+                break;
+            }
+
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void store(uint64_t key, const int* legal_moves, int legal_moves_cnt,
+               const Tensor& output) {
+        if (legal_moves_cnt > max_moves_) {
+            return;
+        }
+
+        //* same key or empty slot, otherwise replace home slot
+        size_t idx = home(key);
+        for (int probe = 0; probe < probes_; probe++) {
+            const size_t cur = (home(key) + probe) & mask_;
+            const auto& entry = entries_[cur];
+
+            if (__atomic_load_n(&entry.cnt, __ATOMIC_RELAXED) < 0 or
+                __atomic_load_n(&entry.key, __ATOMIC_RELAXED) == key) {
+                idx = cur;
+                break;
+            }
+        }
+
+        auto& entry = entries_[idx];
+
+        //* another thread is writing this entry
+        uint32_t seq = __atomic_load_n(&entry.seq, __ATOMIC_RELAXED);
+        if ((seq & 1) or
+            not __atomic_compare_exchange_n(&entry.seq, &seq, seq + 1, false,
+                                            __ATOMIC_ACQ_REL,
+                                            __ATOMIC_RELAXED)) {
+            return;
+        }
+
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        const float value = output.get_element(0);
+        __atomic_store_n(&entry.key, key, __ATOMIC_RELAXED);
+        __atomic_store_n(&entry.cnt, legal_moves_cnt, __ATOMIC_RELAXED);
+        __atomic_store(&entry.value, &value, __ATOMIC_RELAXED);
+
+        float* priors = &priors_[idx * max_moves_];
+        for (int i = 0; i < legal_moves_cnt; i++) {
+            const float prior = output.get_element(legal_moves[i] + 1);
+            __atomic_store(&priors[i], &prior, __ATOMIC_RELAXED);
+        }
+
+        __atomic_store_n(&entry.seq, seq + 2, __ATOMIC_RELEASE);
+    }
+
+    uint64_t get_hits() const { return hits_.load(); }
+
+    uint64_t get_misses() const { return misses_.load(); }
+
+    float get_hit_rate() const {
+        const uint64_t all = get_hits() + get_misses();
+        return all == 0 ? 0.0f : (float)get_hits() / (float)all;
+    }
+
+   private:
+    struct Entry {
+        uint32_t seq;  // odd while entry is written
+        int32_t cnt;   // -1 if empty
+        uint64_t key;
+        float value;
+    };
+
+    inline size_t home(uint64_t key) const {
+        return (key ^ key >> 32) & mask_;
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<float> priors_;
+    size_t mask_;
+    int max_moves_;
+    int probes_;
+    std::atomic<uint64_t> hits_, misses_;
+};
@@ -5,25 +5,24 @@ using namespace nn_avx_fast;
 
 #include <functional>
 #include <games/abstract_game.hpp>
-#include <unordered_map>
+#include <memory>
+
+#include "evaluation_cache.hpp"
 
 class Model : public Sequential {
    public:
     template <class... Layers>
     Model(std::string name, std::shared_ptr<InputLayer> input_layer,
           Layers... layers)
-        : Sequential(name, input_layer, layers...),
-          cache_hit(0),
-          cache_miss(0) {}
+        : Sequential(name, input_layer, layers...) {}
 
     template <class... Layers>
     Model(std::shared_ptr<InputLayer> input_layer, Layers... layers)
-        : Model("Model", input_layer, layers...) {
-        // cache_.reserve(1'000'000);
-    }
+        : Model("Model", input_layer, layers...) {}
 
     virtual void forward() override {
         Sequential::forward();
+        get_input_layer().sparse = false;
 
         //* copy and clear gamestate value from output
         auto& output = Sequential::get_output();
@@ -38,41 +37,165 @@ class Model : public Sequential {
     }
 
     virtual void forward(const std::shared_ptr<AbstractGame<Tensor>>& game) {
-        // uint64_t hash = game->calc_hash();
+        forward(*game);
+    }
 
-        // auto it = cache_.find(hash);
+    //* game is taken by reference, so typed MCTS can pass concrete state
+    virtual void forward(const AbstractGame<Tensor>& game) {
+        forward_cached(game, [&] { Sequential::forward(); });
+    }
 
-        // if (it != cache_.end()) {
-        //     // TODO: we can copy only legal moves
-        //     output->xmm = it->second;
-        //     cache_hit++;
-        //     return;
-        // }
+    /*
+        Forward of game whose first layer output is already in accumulator
+        (see get_feature_layer), only layers after it are computed.
+    */
+    void forward(const Accumulator& accumulator,
+                 const AbstractGame<Tensor>& game) {
+        auto* feature_layer = get_feature_layer();
+        assert(feature_layer != nullptr);
+
+        forward_cached(game, [&] {
+            feature_layer->forward_accumulated(accumulator.values);
+            Sequential::forward_after(feature_layer);
+        });
+    }
 
-        Sequential::forward();
+    /*
+        First layer if it's Linear on input, it can be computed by
+        Accumulator from active features of game, otherwise nullptr.
+        Accumulator sums fp32 weights, so quantized layer isn't returned.
+    */
+    LinearLayer* get_feature_layer() const {
+        for (size_t i = 0; i < layers_count(); i++) {
+            if (get_layer(i)->input_layer != input_layer) {
+                continue;
+            }
 
-        // std::cerr << "AFTER FORWARD\n";
-        // std::cerr << *output << "\n";
+            auto* layer = dynamic_cast<LinearLayer*>(get_layer(i).get());
+            if (layer == nullptr or layer->quantized) {
+                return nullptr;
+            }
 
-        auto& output = Sequential::get_output();
+            return layer;
+        }
+
+        return nullptr;
+    }
+
+    //* cache can be shared by copies of model with the same weights
+    void set_cache(std::shared_ptr<EvaluationCache> cache) { cache_ = cache; }
+
+    const std::shared_ptr<EvaluationCache>& get_cache() const {
+        return cache_;
+    }
+
+    /*
+        Batched evaluation, used by MCTS to evaluate many leaves at once.
+        Fill get_batch_input(i) for i in [0, batch_size) and pass legal moves
+        of every position, AbstractGame::legal_moves is shared by all of them.
+    */
+    Tensor& get_batch_input(size_t idx) {
+        input_layer->reserve_batch(idx + 1);
+        return input_layer->get_batch_output()[idx];
+    }
+
+    //* one batched forward of all layers, see Layer::forward_batch
+    void forward_batch(size_t batch_size,
+                       const std::vector<std::vector<int>>& legal_moves) {
+        assert(batch_size <= input_layer->get_batch_output().size());
+        assert(batch_size <= legal_moves.size());
+
+        Sequential::forward_batch(batch_size);
+        auto& outputs = Sequential::get_batch_output();
+
+        for (size_t i = 0; i < batch_size; i++) {
+            normalize_output(outputs[i], legal_moves[i].data(),
+                             legal_moves[i].size());
+        }
+    }
+
+    float get_value(size_t batch_idx) {
+        return Sequential::get_batch_output()[batch_idx].get_element(0);
+    }
+
+    float get_policy(size_t batch_idx, int move) {
+        return Sequential::get_batch_output()[batch_idx].get_element(move + 1);
+    }
+
+    //* input of game for next forward, sparse when game can give it
+    void set_input(const AbstractGame<Tensor>& game) {
+        auto& input = get_input_layer();
+
+        input.sparse = game.get_sparse_input_for_network(input.sparse_input);
+
+        if (not input.sparse) {
+            game.get_input_for_network(input.get_output());
+        }
+    }
+
+    InputLayer& get_input_layer() {
+        return static_cast<InputLayer&>(*input_layer);
+    }
+
+    void set_input(size_t idx, float val) {
+        input_layer->get_output().set_element(idx, val);
+    }
+
+    void set_input(Tensor input) { input_layer->get_output() = input; }
+
+    float get_value() { return Sequential::get_output().get_element(0); }
+
+    float get_policy(int move) {
+        return Sequential::get_output().get_element(move + 1);
+    }
+
+   private:
+    template <class Forward>
+    void forward_cached(const AbstractGame<Tensor>& game,
+                        Forward&& forward_layers) {
+        uint64_t hash = 0;
+
+        if (cache_) {
+            hash = game.calc_hash();
+
+            if (cache_->find(hash, game.legal_moves.data(),
+                             game.legal_moves_cnt, Sequential::get_output())) {
+                get_input_layer().sparse = false;
+                return;
+            }
+        }
+
+        forward_layers();
+        //* sparse input is used once, dense writers don't know about it
+        get_input_layer().sparse = false;
+
+        normalize_output(Sequential::get_output(), game.legal_moves.data(),
+                         game.legal_moves_cnt);
+
+        if (cache_) {
+            cache_->store(hash, game.legal_moves.data(),
+                          game.legal_moves_cnt, Sequential::get_output());
+        }
+    }
+
+    //* tanh on value, softmax over legal moves on policy
+    void normalize_output(Tensor& output, const int* legal_moves,
+                          int legal_moves_cnt) {
         //* copy and clear gamestate value from output
         const float value = std::tanh(output.get_element(0));
         const float inf = 999999999.99f;
         output.set_element(0, -inf);
 
-        if (game->legal_moves_cnt > 0u) {
+        if (legal_moves_cnt > 0) {
             //* Clear invalid moves
-            static std::vector<bool> legal;
-
-            legal.assign(output.size, false);
+            legal_.assign(output.size, false);
 
-            for (int i = 0; i < game->legal_moves_cnt; i++) {
-                const int move = game->legal_moves[i];
-                legal[move] = true;
+            for (int i = 0; i < legal_moves_cnt; i++) {
+                legal_[legal_moves[i]] = true;
             }
 
             for (int i = 1; i < output.size; i++) {
-                if (not legal[i - 1]) {
+                if (not legal_[i - 1]) {
                     output.set_element(i, -inf);
                 }
             }
@@ -89,27 +212,10 @@ class Model : public Sequential {
         //* copy gamestate value back to output
         output.set_element(0, value);
         // std::cerr << *output << "\n";
-
-        // cache_[hash] = output->xmm;
-        // cache_miss++;
-    }
-
-    void set_input(size_t idx, float val) {
-        input_layer->get_output().set_element(idx, val);
-    }
-
-    void set_input(Tensor input) { input_layer->get_output() = input; }
-
-    float get_value() { return Sequential::get_output().get_element(0); }
-
-    float get_policy(int move) {
-        return Sequential::get_output().get_element(move + 1);
     }
 
-    int cache_hit, cache_miss;
-
-   private:
-    // std::unordered_map<uint64_t, aligned_vector> cache_;
+    std::vector<bool> legal_;
+    std::shared_ptr<EvaluationCache> cache_;
 };
 
 using ModelFactory = std::function<Model(void)>;
\ No newline at end of file
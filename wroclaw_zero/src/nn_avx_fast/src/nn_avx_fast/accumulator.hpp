@@ -0,0 +1,87 @@
+#pragma once
+
+#include "linear_layer.hpp"
+
+namespace nn_avx_fast {
+
+/*
+    Output of LinearLayer before activation for one-hot input given by
+    sorted active features (NNUE-like accumulator). refresh() adds rows of
+    features to bias in the same order as LinearLayer::forward, update()
+    starts from accumulator of other position and adds and subtracts rows
+    of features that differ, cheap when positions are close in tree.
+*/
+class Accumulator {
+   public:
+    void refresh(const LinearLayer &layer, const int *features, int cnt) {
+        values.xmm.resize(layer.bias.xmm_size);
+
+        for (size_t i = 0; i < layer.bias.xmm_size; i++) {
+            values.xmm[i].v = layer.bias.xmm[i].v;
+        }
+
+        for (int k = 0; k < cnt; k++) {
+            add_row(layer, features[k]);
+        }
+    }
+
+    //* from was computed for from_features
+    void update(const Accumulator &from, const LinearLayer &layer,
+                const int *from_features, int from_cnt, const int *features,
+                int cnt) {
+        values.xmm = from.values.xmm;
+
+        int i = 0, j = 0;
+        while (i < from_cnt or j < cnt) {
+            if (j == cnt or (i < from_cnt and from_features[i] < features[j])) {
+                sub_row(layer, from_features[i++]);
+            } else if (i == from_cnt or features[j] < from_features[i]) {
+                add_row(layer, features[j++]);
+            } else {
+                i++;
+                j++;
+            }
+        }
+    }
+
+    //* number of rows update() would add and subtract
+    static int changed_features(const int *a, int a_cnt, const int *b,
+                                int b_cnt) {
+        int i = 0, j = 0, same = 0;
+
+        while (i < a_cnt and j < b_cnt) {
+            if (a[i] < b[j]) {
+                i++;
+            } else if (b[j] < a[i]) {
+                j++;
+            } else {
+                same++;
+                i++;
+                j++;
+            }
+        }
+
+        return a_cnt + b_cnt - 2 * same;
+    }
+
+    Tensor values;
+
+   private:
+    void add_row(const LinearLayer &layer, int feature) {
+        const auto &row = layer.weights[feature];
+
+        for (size_t i = 0; i < row.xmm_size; i++) {
+            values.xmm[i].v = _mm256_add_ps(row.xmm[i].v, values.xmm[i].v);
+        }
+    }
+
+    void sub_row(const LinearLayer &layer, int feature) {
+        const auto &row = layer.weights[feature];
+
+        for (size_t i = 0; i < row.xmm_size; i++) {
+            values.xmm[i].v = _mm256_sub_ps(values.xmm[i].v, row.xmm[i].v);
+        }
+    }
+};
+
+}  // namespace nn_avx_fast
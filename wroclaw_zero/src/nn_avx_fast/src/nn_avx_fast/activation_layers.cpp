@@ -43,16 +43,8 @@ void activationSOFTMAX(Tensor &output) {
 };
 
 void activationTANH(Tensor &output) {
-    const __m256 one = _mm256_set1_ps(1.0f);
-    const __m256 minus_one = _mm256_set1_ps(-1.0f);
-
     for (size_t i = 0; i < output.xmm_size; ++i) {
-        auto ex = exp256_ps(output.xmm[i].v);
-        auto emx = exp256_ps(_mm256_mul_ps(output.xmm[i].v, minus_one));
-
-        output.xmm[i].v = _mm256_sub_ps(ex, emx);
-        auto divisor = _mm256_add_ps(ex, emx);
-        output.xmm[i].v = _mm256_div_ps(output.xmm[i].v, divisor);
+        output.xmm[i].v = tanh256_ps(output.xmm[i].v);
     }
 };
 
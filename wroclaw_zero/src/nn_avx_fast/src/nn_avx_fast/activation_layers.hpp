@@ -60,6 +60,13 @@ inline __m256 exp256_ps(const __m256 &V) {
 #undef MUL
 #undef FMA
 
+inline __m256 tanh256_ps(const __m256 &V) {
+    const __m256 ex = exp256_ps(V);
+    const __m256 emx = exp256_ps(_mm256_mul_ps(V, _mm256_set1_ps(-1.0f)));
+
+    return _mm256_div_ps(_mm256_sub_ps(ex, emx), _mm256_add_ps(ex, emx));
+}
+
 using Activation = std::function<void(Tensor &)>;
 
 void activationNONE(Tensor &);
@@ -68,4 +75,38 @@ void activationSIGMOID(Tensor &);
 void activationSOFTMAX(Tensor &);
 void activationTANH(Tensor &);
 
+/*
+    Activations which fused kernels apply to accumulators still in
+    registers, OTHER is applied by Activation after the kernel.
+*/
+enum class ActivationKind { NONE, RELU, TANH, OTHER };
+
+inline ActivationKind get_activation_kind(const Activation &activation) {
+    const auto *function = activation.target<void (*)(Tensor &)>();
+
+    if (function == nullptr) {
+        return ActivationKind::OTHER;
+    } else if (*function == activationNONE) {
+        return ActivationKind::NONE;
+    } else if (*function == activationRELU) {
+        return ActivationKind::RELU;
+    } else if (*function == activationTANH) {
+        return ActivationKind::TANH;
+    }
+
+    return ActivationKind::OTHER;
+}
+
+//* same result as activation of Kind applied to tensor of this chunk
+template <ActivationKind Kind>
+inline __m256 activate256_ps(const __m256 &V) {
+    if constexpr (Kind == ActivationKind::RELU) {
+        return _mm256_max_ps(V, _mm256_setzero_ps());
+    } else if constexpr (Kind == ActivationKind::TANH) {
+        return tanh256_ps(V);
+    } else {
+        return V;
+    }
+}
+
 }  // namespace nn_avx_fast
\ No newline at end of file
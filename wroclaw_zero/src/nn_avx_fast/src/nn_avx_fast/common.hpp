@@ -6,3 +6,4 @@
 #include "sequential.hpp"
 #include "conv2d_layer.hpp"
 #include "flatten_layer.hpp"
+#include "accumulator.hpp"
@@ -150,31 +150,35 @@ class Conv2DLayer : public Layer {
             output.xmm[i].v = bias.xmm[i].v;
         }
 
-        for (size_t j = 0; j < input.size; j++) {
-            const float val = input.xmm[0].f[j];
+        if (const auto* sparse = input_layer->get_sparse_output()) {
+            for (int k = 0; k < sparse->count; k++) {
+                add_input(sparse->indices[k], sparse->value(k));
+            }
+        } else {
+            for (size_t j = 0; j < input.size; j++) {
+                add_input(j, input.xmm[0].f[j]);
+            }
+        }
+    }
 
-            if (val == 0.0f) {
-                continue;
-            } else if (val == 1.0f) {
-                // std::cerr << "J:" << j << "val:" << val << "\n";
-                for (size_t i = 0; i < weight_idx[j].size(); i++) {
-                    auto idx = weight_idx[j][i];
-                    // std::cerr << "IDX:" << idx << "\n";
-
-                    output.xmm[idx].v =
-                        _mm256_add_ps(weight_val[j][i].v, output.xmm[idx].v);
-                }
-                // std::cerr << output << "\n";
-            } else {
-                const __m256 fm = _mm256_set1_ps(val);
+    /*
+        Same sparse weights as forward(), every nonzero chunk of weights
+        is loaded once for rows_block samples.
+    */
+    void forward_batch(size_t batch_size) override {
+        assert(input_layer != nullptr and
+               "Layer must be linked to input layer.");
 
-                for (size_t i = 0; i < weight_idx[j].size(); i++) {
-                    // a * b + c
-                    auto idx = weight_idx[j][i];
-                    output.xmm[idx].v = _mm256_fmadd_ps(fm, weight_val[j][i].v,
-                                                        output.xmm[idx].v);
-                }
-            }
+        reserve_batch(batch_size);
+        auto& inputs = input_layer->get_batch_output();
+        assert(batch_size <= inputs.size());
+
+        size_t row = 0;
+        for (; row + rows_block <= batch_size; row += rows_block) {
+            forward_rows<rows_block>(inputs, row);
+        }
+        for (; row < batch_size; row++) {
+            forward_rows<1>(inputs, row);
         }
     }
 
@@ -220,6 +224,73 @@ class Conv2DLayer : public Layer {
 
     __attribute__((aligned(32))) std::vector<std::vector<__m256_f>> weight_val;
     std::vector<std::vector<int>> weight_idx;
+
+   private:
+    //* weights of input j times val added to output
+    inline void add_input(size_t j, float val) {
+        if (val == 0.0f) {
+            return;
+        } else if (val == 1.0f) {
+            for (size_t i = 0; i < weight_idx[j].size(); i++) {
+                auto idx = weight_idx[j][i];
+
+                output.xmm[idx].v =
+                    _mm256_add_ps(weight_val[j][i].v, output.xmm[idx].v);
+            }
+        } else {
+            const __m256 fm = _mm256_set1_ps(val);
+
+            for (size_t i = 0; i < weight_idx[j].size(); i++) {
+                // a * b + c
+                auto idx = weight_idx[j][i];
+                output.xmm[idx].v = _mm256_fmadd_ps(fm, weight_val[j][i].v,
+                                                    output.xmm[idx].v);
+            }
+        }
+    }
+
+    static constexpr int rows_block = 4;
+
+    template <int Rows>
+    void forward_rows(const TensorBatch& inputs, size_t first_row) {
+        const float* in[Rows];
+        __m256_f* out[Rows];
+
+        for (int r = 0; r < Rows; r++) {
+            in[r] = inputs[first_row + r].xmm[0].f;
+            out[r] = batch_output[first_row + r].xmm.data();
+
+            for (size_t i = 0; i < output.xmm_size; i++) {
+                out[r][i].v = bias.xmm[i].v;
+            }
+        }
+
+        const size_t in_size = inputs[first_row].size;
+
+        for (size_t j = 0; j < in_size; j++) {
+            __m256 fm[Rows];
+            bool non_zero = false;
+
+            for (int r = 0; r < Rows; r++) {
+                fm[r] = _mm256_set1_ps(in[r][j]);
+                non_zero |= in[r][j] != 0.0f;
+            }
+
+            if (not non_zero) {
+                continue;
+            }
+
+            for (size_t i = 0; i < weight_idx[j].size(); i++) {
+                const auto idx = weight_idx[j][i];
+                const __m256 w = weight_val[j][i].v;
+
+                for (int r = 0; r < Rows; r++) {
+                    // a * b + c
+                    out[r][idx].v = _mm256_fmadd_ps(fm[r], w, out[r][idx].v);
+                }
+            }
+        }
+    }
 };
 
 }  // namespace nn_avx_fast
@@ -13,6 +13,13 @@ class FlattenLayer : public Layer {
 
     Tensor &get_output() override { return input_layer->get_output(); }
 
+    const SparseTensor *get_sparse_output() override {
+        return input_layer->get_sparse_output();
+    }
+
+    //* next layers read input of any shape as vector
+    bool fuse() override { return false; }
+
     void forward() override {
         assert(input_layer != nullptr and
                "Layer must be linked to input layer.");
@@ -21,6 +28,13 @@ class FlattenLayer : public Layer {
         input.shape = std::vector<size_t>{input.size};
     }
 
+    TensorBatch &get_batch_output() override {
+        return input_layer->get_batch_output();
+    }
+
+    //* rows are flat already, only shape of single output is changed
+    void forward_batch(size_t batch_size) override {}
+
     virtual void save(std::ostream &os) override {}
 
     virtual void load(std::istream &is) override {}
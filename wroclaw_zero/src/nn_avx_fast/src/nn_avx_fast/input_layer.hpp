@@ -10,6 +10,7 @@ class InputLayer : public Layer {
     InputLayer(std::string name, std::vector<size_t> input_shape)
         : Layer(name) {
         output = Tensor(input_shape);
+        sparse_input.indices.resize(output.size);
     }
 
     InputLayer(std::vector<size_t> input_shape)
@@ -17,6 +18,10 @@ class InputLayer : public Layer {
 
     virtual void init() override {}
     virtual void forward() override {}
+    //* rows are filled by caller, see Model::get_batch_input
+    virtual void forward_batch(size_t batch_size) override {
+        reserve_batch(batch_size);
+    }
 
     virtual void save(std::ostream &os) override {}
     virtual void load(std::istream &is) override {}
@@ -25,6 +30,17 @@ class InputLayer : public Layer {
 
     void set(size_t idx, float val) { output.set_element(idx, val); }
 
+    /*
+        Input is sparse_input instead of output while sparse is set, next
+        layers read it through get_sparse_output.
+    */
+    const SparseTensor *get_sparse_output() override {
+        return sparse ? &sparse_input : nullptr;
+    }
+
+    SparseTensor sparse_input;
+    bool sparse = false;
+
     virtual void fill(const float value) override { output.fill(value); }
 
     virtual void fill_random(const float min_value,
@@ -31,10 +31,46 @@ class Layer {
     }
 
     virtual Tensor &get_output() { return output; }
+    //* nullptr when output is only dense
+    virtual const SparseTensor *get_sparse_output() { return nullptr; }
     virtual void init() = 0;
     virtual void forward() = 0;
     virtual void precompute() {}
 
+    /*
+        Fusion pass run by Sequential when model is built, activation and
+        links are fixed then. Layer prepares fused kernels and returns
+        false when its forward does nothing and can be skipped.
+    */
+    virtual bool fuse() { return true; }
+
+    /*
+        Forwards first batch_size rows of input_layer->get_batch_output()
+        at once, weights are read once for the whole batch instead of once
+        per sample. Results are equal to forward() of every row.
+    */
+    virtual void forward_batch(size_t batch_size) = 0;
+    virtual TensorBatch &get_batch_output() { return batch_output; }
+
+    //* rows are allocated once and reused by next batches
+    void reserve_batch(size_t batch_size) {
+        while (batch_output.size() < batch_size) {
+            batch_output.emplace_back(output.shape);
+        }
+    }
+
+    /*
+        Int8 inference. calibrate() records range of input of last forward,
+        quantize() switches layer to int8 weights scaled by that range and
+        returns false if layer has no int8 path or its input can't be
+        quantized. Ranges can be saved once and loaded instead of
+        calibration.
+    */
+    virtual void calibrate() {}
+    virtual bool quantize() { return false; }
+    virtual void save_calibration(std::ostream &os) {}
+    virtual void load_calibration(std::istream &is) {}
+
     virtual void save(std::ostream &os) = 0;
     virtual void load(std::istream &is) = 0;
 
@@ -49,6 +85,7 @@ class Layer {
 
    protected:
     Tensor output;
+    TensorBatch batch_output;
 };
 
 }  // namespace nn_avx_fast
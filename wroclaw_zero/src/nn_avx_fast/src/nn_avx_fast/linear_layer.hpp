@@ -1,4 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
 #include "layer.hpp"
 
 namespace nn_avx_fast {
@@ -23,14 +27,20 @@ class LinearLayer : public Layer {
     LinearLayer(size_t out_features, Activation activation = activationNONE)
         : LinearLayer("linear", out_features, activation) {}
 
+    //* input of any shape is read as vector, Flatten before is folded away
     void init() override {
-        assert(input_layer->get_output().shape.size() == 1 and
-               "Input must be a vector");
-
         auto in_features = input_layer->get_output().size;
         weights.resize(in_features, Tensor({out_features}));
         bias = Tensor({out_features});
         output = Tensor(std::vector<size_t>{out_features});
+        active_idx.resize(in_features);
+        active_val.resize(in_features);
+    }
+
+    //* known activations are applied by kernels, see with_activation
+    bool fuse() override {
+        activation_kind = get_activation_kind(activation);
+        return true;
     }
 
     void forward() override {
@@ -39,36 +49,146 @@ class LinearLayer : public Layer {
 
         const auto &input = input_layer->get_output();
 
-        assert(input.shape.size() == 1 and "Input must be a vector");
+        assert(input.size == weights.size() and "Invalid size of input");
+
+        const auto *sparse = input_layer->get_sparse_output();
 
-        for (size_t i = 0; i < output.xmm_size; i++) {
-            output.xmm[i].v = bias.xmm[i].v;
+        if (quantized) {
+            if (sparse) {
+                quantize_input(*sparse);
+            } else {
+                quantize_input(input);
+            }
+
+            with_activation(output, [&](auto kind) {
+                forward_int8<decltype(kind)::value>(output);
+            });
+            return;
         }
 
-        assert(input.shape.size() == 1 and "Input must be a vector");
-            
-        for (int j = 0; j < input.size; j++) {
-            const float val = input.xmm[0].f[j];
+        const int cnt = sparse ? gather_active(*sparse) : gather_active(input);
 
-            if (val == 0.0f) {
-                continue;
-            } else if (val == 1.0f) {
-                for (int i = 0; i < output.xmm_size; i++) {
-                    output.xmm[i].v =
-                        _mm256_add_ps(weights[j].xmm[i].v, output.xmm[i].v);
-                }
-            } else {
-                const __m256 fm = _mm256_set1_ps(val);
+        with_activation(output, [&](auto kind) {
+            forward_active<decltype(kind)::value>(cnt);
+        });
+    }
 
-                for (int i = 0; i < output.xmm_size; i++) {
-                    // a * b + c
-                    output.xmm[i].v = _mm256_fmadd_ps(fm, weights[j].xmm[i].v,
-                                                      output.xmm[i].v);
-                }
+    //* output before activation was computed by Accumulator
+    void forward_accumulated(const Tensor &accumulated) {
+        with_activation(output, [&](auto kind) {
+            for (size_t i = 0; i < output.xmm_size; i++) {
+                output.xmm[i].v =
+                    activate256_ps<decltype(kind)::value>(accumulated.xmm[i].v);
+            }
+        });
+    }
+
+    /*
+        GEMM of batch rows and weights. Kernel keeps block of
+        rows_block x chunks_block outputs in registers, so every loaded
+        chunk of weights is used by rows_block samples and weights are
+        streamed once per rows_block samples. Order of additions is the
+        same as in forward(), so results are equal.
+    */
+    void forward_batch(size_t batch_size) override {
+        assert(input_layer != nullptr and
+               "Layer must be linked to input layer.");
+
+        reserve_batch(batch_size);
+        auto &inputs = input_layer->get_batch_output();
+        assert(batch_size <= inputs.size());
+
+        if (quantized) {
+            for (size_t i = 0; i < batch_size; i++) {
+                quantize_input(inputs[i]);
+                with_activation(batch_output[i], [&](auto kind) {
+                    forward_int8<decltype(kind)::value>(batch_output[i]);
+                });
+            }
+            return;
+        }
+
+        with_activation_batch(batch_size, [&](auto kind) {
+            constexpr ActivationKind Kind = decltype(kind)::value;
+
+            size_t row = 0;
+            for (; row + rows_block <= batch_size; row += rows_block) {
+                gemm_rows<rows_block, Kind>(inputs, row);
+            }
+            for (; row < batch_size; row++) {
+                gemm_rows<1, Kind>(inputs, row);
+            }
+        });
+    }
+
+    void calibrate() override {
+        if (const auto *sparse = input_layer->get_sparse_output()) {
+            for (int k = 0; k < sparse->count; k++) {
+                input_min = std::min(input_min, sparse->value(k));
+                input_max = std::max(input_max, sparse->value(k));
             }
+            return;
         }
 
-        activation(output);
+        const auto &input = input_layer->get_output();
+
+        for (size_t j = 0; j < input.size; j++) {
+            input_min = std::min(input_min, input.get_element(j));
+            input_max = std::max(input_max, input.get_element(j));
+        }
+    }
+
+    /*
+        Weights are int8 with one scale for whole layer, inputs are u8 in
+        [0, 127] so two products summed by _mm256_maddubs_epi16 can't
+        saturate int16, pairs are summed to int32 by _mm256_madd_epi16.
+        Weights are grouped by 4 inputs, chunk of group holds 8 outputs
+        times 4 inputs, so one broadcast of 4 inputs updates 8 outputs.
+    */
+    bool quantize() override {
+        //* u8 inputs, negative ones (no ReLU before) would need zero point
+        if (input_min < 0.0f or input_max <= 0.0f) {
+            return false;
+        }
+
+        float weights_max = 0.0f;
+        for (const auto &weight : weights) {
+            for (size_t o = 0; o < weight.size; o++) {
+                weights_max = std::max(weights_max,
+                                       std::abs(weight.get_element(o)));
+            }
+        }
+
+        input_scale = int8_max / input_max;
+        weight_scale = int8_max / std::max(weights_max, 1e-9f);
+        dequantize_scale = 1.0f / (input_scale * weight_scale);
+
+        const size_t groups = (weights.size() + 3) / 4;
+        weights_int8.assign(groups * output.xmm_size, __m256i_i{});
+        input_int8.assign(groups, 0);
+        accumulators.resize(output.xmm_size);
+
+        for (size_t j = 0; j < weights.size(); j++) {
+            for (size_t o = 0; o < out_features; o++) {
+                auto *chunk =
+                    weights_int8[(j / 4) * output.xmm_size + o / 8].i8;
+                chunk[(o % 8) * 4 + j % 4] = (int8_t)std::round(
+                    weights[j].get_element(o) * weight_scale);
+            }
+        }
+
+        quantized = true;
+        return true;
+    }
+
+    void save_calibration(std::ostream &os) override {
+        os.write(reinterpret_cast<const char *>(&input_min), sizeof(float));
+        os.write(reinterpret_cast<const char *>(&input_max), sizeof(float));
+    }
+
+    void load_calibration(std::istream &is) override {
+        is.read(reinterpret_cast<char *>(&input_min), sizeof(float));
+        is.read(reinterpret_cast<char *>(&input_max), sizeof(float));
     }
 
     virtual void save(std::ostream &os) override {
@@ -79,12 +199,14 @@ class LinearLayer : public Layer {
         bias.save(os);
     }
 
+    //* new weights are fp32 again until next quantize()
     virtual void load(std::istream &is) override {
         for (auto &weight : weights) {
             weight.load(is);
         }
 
         bias.load(is);
+        quantized = false;
     }
 
     virtual size_t count_params() const override {
@@ -110,6 +232,260 @@ class LinearLayer : public Layer {
     std::vector<Tensor> weights;
     Tensor bias;
     size_t out_features;
+
+    //* int8 inference, see quantize()
+    bool quantized = false;
+    float input_min = 0.0f;
+    float input_max = 0.0f;
+    float input_scale = 1.0f;
+    float weight_scale = 1.0f;
+
+   private:
+    template <ActivationKind Kind>
+    using kind_constant = std::integral_constant<ActivationKind, Kind>;
+
+    /*
+        Calls kernel(kind_constant) with activation of layer, so it's
+        applied to accumulators before they are stored. Activation isn't
+        known before fuse() and other ones make second pass over out.
+    */
+    template <class Kernel>
+    void with_activation(Tensor &out, Kernel &&kernel) {
+        switch (activation_kind) {
+            case ActivationKind::NONE:
+                kernel(kind_constant<ActivationKind::NONE>());
+                break;
+            case ActivationKind::RELU:
+                kernel(kind_constant<ActivationKind::RELU>());
+                break;
+            case ActivationKind::TANH:
+                kernel(kind_constant<ActivationKind::TANH>());
+                break;
+            default:
+                kernel(kind_constant<ActivationKind::NONE>());
+                activation(out);
+        }
+    }
+
+    template <class Kernel>
+    void with_activation_batch(size_t batch_size, Kernel &&kernel) {
+        if (activation_kind != ActivationKind::OTHER) {
+            with_activation(output, kernel);
+            return;
+        }
+
+        kernel(kind_constant<ActivationKind::NONE>());
+        for (size_t i = 0; i < batch_size; i++) {
+            activation(batch_output[i]);
+        }
+    }
+
+    //* nonzero inputs, in increasing order like rows of dense forward
+    int gather_active(const Tensor &input) {
+        int cnt = 0;
+
+        for (size_t j = 0; j < input.size; j++) {
+            const float val = input.xmm[0].f[j];
+
+            if (val != 0.0f) {
+                active_idx[cnt] = j;
+                active_val[cnt++] = val;
+            }
+        }
+
+        return cnt;
+    }
+
+    int gather_active(const SparseTensor &input) {
+        for (int k = 0; k < input.count; k++) {
+            active_idx[k] = input.indices[k];
+            active_val[k] = input.value(k);
+        }
+
+        return input.count;
+    }
+
+    template <ActivationKind Kind>
+    void forward_active(int cnt) {
+        size_t chunk = 0;
+        for (; chunk + chunks_block <= output.xmm_size;
+             chunk += chunks_block) {
+            active_kernel<Kind, chunks_block>(cnt, chunk);
+        }
+        for (; chunk < output.xmm_size; chunk++) {
+            active_kernel<Kind, 1>(cnt, chunk);
+        }
+    }
+
+    /*
+        Bias, rows of active inputs and activation of Chunks outputs in
+        registers, output is written once. fma with 1 is exact, so sums
+        are equal to adding rows of one-hot inputs.
+    */
+    template <ActivationKind Kind, int Chunks>
+    void active_kernel(int cnt, size_t chunk) {
+        __m256 acc[Chunks];
+
+        for (int c = 0; c < Chunks; c++) {
+            acc[c] = bias.xmm[chunk + c].v;
+        }
+
+        for (int k = 0; k < cnt; k++) {
+            const __m256 fm = _mm256_set1_ps(active_val[k]);
+            const __m256_f *w = weights[active_idx[k]].xmm.data() + chunk;
+
+            for (int c = 0; c < Chunks; c++) {
+                // a * b + c
+                acc[c] = _mm256_fmadd_ps(fm, w[c].v, acc[c]);
+            }
+        }
+
+        for (int c = 0; c < Chunks; c++) {
+            output.xmm[chunk + c].v = activate256_ps<Kind>(acc[c]);
+        }
+    }
+
+    ActivationKind activation_kind = ActivationKind::OTHER;
+    std::vector<int> active_idx;
+    std::vector<float> active_val;
+
+    static constexpr float int8_max = 127.0f;
+
+    inline uint8_t quantize_value(float val) const {
+        val *= input_scale;
+        return (uint8_t)(std::min(std::max(val, 0.0f), int8_max) + 0.5f);
+    }
+
+    void quantize_input(const Tensor &input) {
+        auto *bytes = reinterpret_cast<uint8_t *>(input_int8.data());
+
+        for (size_t j = 0; j < input.size; j++) {
+            bytes[j] = quantize_value(input.xmm[0].f[j]);
+        }
+    }
+
+    void quantize_input(const SparseTensor &input) {
+        std::fill(input_int8.begin(), input_int8.end(), 0);
+        auto *bytes = reinterpret_cast<uint8_t *>(input_int8.data());
+
+        for (int k = 0; k < input.count; k++) {
+            bytes[input.indices[k]] = quantize_value(input.value(k));
+        }
+    }
+
+    //* input is already quantized to input_int8
+    template <ActivationKind Kind>
+    void forward_int8(Tensor &out) {
+        const size_t chunks = output.xmm_size;
+        const __m256i ones = _mm256_set1_epi16(1);
+
+        for (size_t i = 0; i < chunks; i++) {
+            accumulators[i].v = _mm256_setzero_si256();
+        }
+
+        for (size_t g = 0; g < input_int8.size(); g++) {
+            //* 4 zero inputs, inputs are mostly one-hot planes
+            if (input_int8[g] == 0) {
+                continue;
+            }
+
+            const __m256i in = _mm256_set1_epi32((int)input_int8[g]);
+            const __m256i_i *w = &weights_int8[g * chunks];
+
+            for (size_t i = 0; i < chunks; i++) {
+                const __m256i products = _mm256_maddubs_epi16(in, w[i].v);
+                accumulators[i].v = _mm256_add_epi32(
+                    accumulators[i].v, _mm256_madd_epi16(products, ones));
+            }
+        }
+
+        const __m256 scale = _mm256_set1_ps(dequantize_scale);
+
+        for (size_t i = 0; i < chunks; i++) {
+            out.xmm[i].v = activate256_ps<Kind>(_mm256_fmadd_ps(
+                _mm256_cvtepi32_ps(accumulators[i].v), scale, bias.xmm[i].v));
+        }
+    }
+
+    float dequantize_scale = 1.0f;
+    aligned_vector_i weights_int8;
+    std::vector<uint32_t> input_int8;  // groups of 4 u8 inputs
+    aligned_vector_i accumulators;
+
+    //* 3 x 4 accumulators + 4 weights = 16 ymm registers, hidden layers
+    //* have multiple of 32 outputs
+    static constexpr int rows_block = 3;
+    static constexpr int chunks_block = 4;
+
+    template <int Rows, ActivationKind Kind>
+    void gemm_rows(const TensorBatch &inputs, size_t first_row) {
+        const float *in[Rows];
+        __m256_f *out[Rows];
+
+        for (int r = 0; r < Rows; r++) {
+            in[r] = inputs[first_row + r].xmm[0].f;
+            out[r] = batch_output[first_row + r].xmm.data();
+        }
+
+        const size_t in_features = inputs[first_row].size;
+        size_t chunk = 0;
+        for (; chunk + chunks_block <= output.xmm_size;
+             chunk += chunks_block) {
+            gemm_kernel<Rows, chunks_block, Kind>(in, out, in_features, chunk);
+        }
+        for (; chunk < output.xmm_size; chunk++) {
+            gemm_kernel<Rows, 1, Kind>(in, out, in_features, chunk);
+        }
+    }
+
+    template <int Rows, int Chunks, ActivationKind Kind>
+    void gemm_kernel(const float *const *in, __m256_f *const *out,
+                     size_t in_features, size_t chunk) {
+        __m256 acc[Rows][Chunks];
+
+        for (int r = 0; r < Rows; r++) {
+            for (int c = 0; c < Chunks; c++) {
+                acc[r][c] = bias.xmm[chunk + c].v;
+            }
+        }
+
+        for (size_t j = 0; j < in_features; j++) {
+            float val[Rows];
+            bool non_zero = false;
+
+            for (int r = 0; r < Rows; r++) {
+                val[r] = in[r][j];
+                non_zero |= val[r] != 0.0f;
+            }
+
+            //* inputs are mostly one-hot planes
+            if (not non_zero) {
+                continue;
+            }
+
+            const __m256_f *w = weights[j].xmm.data() + chunk;
+            __m256 wv[Chunks];
+
+            for (int c = 0; c < Chunks; c++) {
+                wv[c] = w[c].v;
+            }
+
+            for (int r = 0; r < Rows; r++) {
+                const __m256 fm = _mm256_set1_ps(val[r]);
+
+                for (int c = 0; c < Chunks; c++) {
+                    // a * b + c, exact for 0 and 1 like in forward()
+                    acc[r][c] = _mm256_fmadd_ps(fm, wv[c], acc[r][c]);
+                }
+            }
+        }
+
+        for (int r = 0; r < Rows; r++) {
+            for (int c = 0; c < Chunks; c++) {
+                out[r][chunk + c].v = activate256_ps<Kind>(acc[r][c]);
+            }
+        }
+    }
 };
 
 }  // namespace nn_avx_fast
\ No newline at end of file
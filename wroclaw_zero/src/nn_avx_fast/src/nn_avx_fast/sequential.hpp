@@ -1,6 +1,7 @@
 #ifndef SEQUENTIAL_HPP
 #define SEQUENTIAL_HPP
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -19,6 +20,8 @@ class Sequential : public Layer {
         if constexpr (sizeof...(layers) > 0) {
             link_layers(layers...);
         }
+
+        fuse();
     }
 
     template <class... Layers>
@@ -32,11 +35,77 @@ class Sequential : public Layer {
     }
 
     virtual void forward() override {
-        for (auto &layer : m_layers) {
+        for (auto *layer : m_fused) {
             layer->forward();
         }
     }
 
+    //* layers with something to do in forward, see Layer::fuse
+    virtual bool fuse() override {
+        m_fused.clear();
+
+        for (auto &layer : m_layers) {
+            if (layer->fuse()) {
+                m_fused.push_back(layer.get());
+            }
+        }
+
+        return true;
+    }
+
+    //* forward of fused layers after layer, its output is already computed
+    void forward_after(const Layer *layer) {
+        auto it = std::find(m_fused.begin(), m_fused.end(), layer);
+        assert(it != m_fused.end() and "Layer isn't in forward list.");
+
+        for (++it; it != m_fused.end(); ++it) {
+            (*it)->forward();
+        }
+    }
+
+    const std::shared_ptr<Layer> &get_layer(size_t idx) const {
+        return m_layers[idx];
+    }
+
+    size_t layers_count() const { return m_layers.size(); }
+
+    virtual TensorBatch &get_batch_output() override {
+        return m_layers.back()->get_batch_output();
+    }
+
+    virtual void forward_batch(size_t batch_size) override {
+        for (auto *layer : m_fused) {
+            layer->forward_batch(batch_size);
+        }
+    }
+
+    virtual void calibrate() override {
+        for (auto &layer : m_layers) {
+            layer->calibrate();
+        }
+    }
+
+    //* true if any layer is quantized
+    virtual bool quantize() override {
+        bool quantized = false;
+        for (auto &layer : m_layers) {
+            quantized |= layer->quantize();
+        }
+        return quantized;
+    }
+
+    virtual void save_calibration(std::ostream &os) override {
+        for (auto &layer : m_layers) {
+            layer->save_calibration(os);
+        }
+    }
+
+    virtual void load_calibration(std::istream &is) override {
+        for (auto &layer : m_layers) {
+            layer->load_calibration(is);
+        }
+    }
+
     virtual void save(std::ostream &os) override {
         for (auto &layer : m_layers) {
             layer->save(os);
@@ -72,6 +141,7 @@ class Sequential : public Layer {
     void append(std::shared_ptr<Layer> layer) {
         m_layers.push_back(std::move(layer));
         m_layers.back()->link(m_layers[(int)m_layers.size() - 2]);
+        fuse();
     }
 
    private:
@@ -86,6 +156,7 @@ class Sequential : public Layer {
     }
 
     std::vector<std::shared_ptr<Layer>> m_layers;
+    std::vector<Layer *> m_fused;
 };
 
 }  // namespace nn_avx_fast
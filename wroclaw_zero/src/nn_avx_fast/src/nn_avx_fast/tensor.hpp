@@ -3,6 +3,7 @@
 #include <immintrin.h>
 
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <random>
 #include <utility>  // move
@@ -15,13 +16,35 @@ union __m256_f {
     float f[8];
 };
 
+union __m256i_i {
+    __m256i v;
+    int8_t i8[32];
+    int32_t i32[8];
+};
+
 // https://stackoverflow.com/questions/8456236/how-is-a-vectors-data-aligned/8456491#8456491
 // Since C++17 std::vector will work
 
 using aligned_vector = std::vector<__m256_f>;
+using aligned_vector_i = std::vector<__m256i_i>;
+
+/*
+    Tensor given by sorted indices of its first count nonzero elements,
+    values are empty when all of them are 1 (one-hot inputs). indices
+    have room for whole tensor, so producers don't allocate.
+*/
+struct SparseTensor {
+    std::vector<int> indices;
+    std::vector<float> values;
+    int count = 0;
+
+    float value(int k) const { return values.empty() ? 1.0f : values[k]; }
+};
 
 class Tensor {
    public:
+    using Sparse = SparseTensor;
+
     explicit Tensor(const std::vector<size_t> &shape) : shape(shape) {
         size = 1;
 
@@ -264,4 +287,11 @@ class Tensor {
     size_t size;
 };
 
+/*
+    Batch of samples for Layer::forward_batch, row i is sample i with shape
+    of layer output. Every row starts at its own chunk, so per sample code
+    (activations, get_element3D, ...) works on rows unchanged.
+*/
+using TensorBatch = std::vector<Tensor>;
+
 }  // namespace nn_avx_fast
\ No newline at end of file
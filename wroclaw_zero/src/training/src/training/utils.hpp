@@ -124,5 +124,74 @@ MCTSConfig parse_mcts_config(YAML::Node config) {
             config["init_reserved_nodes"].as<int>();
     }
 
+    if (config["max_nodes"]) {
+        mcts_config.max_nodes = config["max_nodes"].as<int>();
+    }
+
+    if (config["batch_size"]) {
+        mcts_config.batch_size = config["batch_size"].as<int>();
+    }
+
+    if (config["virtual_loss"]) {
+        mcts_config.virtual_loss = config["virtual_loss"].as<float>();
+    }
+
+    if (config["search_threads"]) {
+        mcts_config.search_threads = config["search_threads"].as<int>();
+    }
+
+    if (config["transposition_table_size"]) {
+        mcts_config.transposition_table_size =
+            config["transposition_table_size"].as<int>();
+    }
+
+    if (config["compact_threshold"]) {
+        mcts_config.compact_threshold =
+            config["compact_threshold"].as<float>();
+    }
+
+    if (config["lazy_children"]) {
+        mcts_config.lazy_children = config["lazy_children"].as<bool>();
+    }
+
+    if (config["smart_stop"]) {
+        mcts_config.smart_stop = config["smart_stop"].as<float>();
+    }
+
+    if (config["full_search_probability"]) {
+        mcts_config.full_search_probability =
+            config["full_search_probability"].as<float>();
+    }
+
+    if (config["fast_iterations_per_turn"]) {
+        mcts_config.fast_iterations_per_turn =
+            config["fast_iterations_per_turn"].as<int>();
+    }
+
+    if (config["gumbel"]) {
+        mcts_config.gumbel = config["gumbel"].as<bool>();
+    }
+
+    if (config["gumbel_actions"]) {
+        mcts_config.gumbel_actions = config["gumbel_actions"].as<int>();
+    }
+
+    if (config["gumbel_c_visit"]) {
+        mcts_config.gumbel_c_visit = config["gumbel_c_visit"].as<float>();
+    }
+
+    if (config["gumbel_c_scale"]) {
+        mcts_config.gumbel_c_scale = config["gumbel_c_scale"].as<float>();
+    }
+
+    if (config["seed"]) {
+        mcts_config.seed = config["seed"].as<int>();
+    }
+
+    if (config["incremental_accumulator"]) {
+        mcts_config.incremental_accumulator =
+            config["incremental_accumulator"].as<bool>();
+    }
+
     return mcts_config;
 }
\ No newline at end of file